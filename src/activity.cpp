@@ -0,0 +1,66 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/activity.cpp
+DESCRIPTION: Lock-free feed of finished kills
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "activity.h"
+
+
+bool ActivityRing::push(const Activity& activity) {
+    /*
+    Append an activity. Producer only.
+
+    If the consumer has fallen a full ring behind, the new activity is
+    dropped and counted rather than overwriting one it may be reading.
+    */
+
+    std::size_t position = tail.load(std::memory_order_relaxed);
+
+    if (position - head.load(std::memory_order_acquire) >= ACTIVITY_CAPACITY) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    slots[position & (ACTIVITY_CAPACITY - 1)] = activity;
+    tail.store(position + 1, std::memory_order_release);
+
+    return true;
+}
+
+std::size_t ActivityRing::drain(Activity* out, std::size_t max) {
+    /*
+    Move up to `max` activities, oldest first, into `out`. Consumer only.
+
+    Returns the amount moved.
+    */
+
+    std::size_t position = head.load(std::memory_order_relaxed);
+    std::size_t available = tail.load(std::memory_order_acquire) - position;
+
+    std::size_t count = (available < max) ? available : max;
+
+    for (std::size_t i = 0; i < count; i++) {
+        out[i] = slots[(position + i) & (ACTIVITY_CAPACITY - 1)];
+    }
+
+    head.store(position + count, std::memory_order_release);
+
+    return count;
+}
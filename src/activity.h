@@ -0,0 +1,68 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/activity.h
+DESCRIPTION: Lock-free feed of finished kills
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef ACTIVITY_H
+#define ACTIVITY_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+// Length of the name carried by an activity, including the null terminator
+#define ACTIVITY_NAME_LENGTH 260
+
+// Activities buffered between drains. Must be a power of two.
+#define ACTIVITY_CAPACITY 256
+
+
+struct Activity {
+    uint32_t pid;
+    // `Kills::CONFIRMED` or `Kills::GAVE_UP`
+    int32_t result;
+    // Milliseconds since the Unix epoch
+    int64_t timestamp;
+    // Milliseconds from the kill being requested to it finishing
+    uint32_t latency;
+    uint32_t attempts;
+    // ID in the `TargetRegistry`, or `TARGET_NONE`
+    uint32_t target;
+    char name[ACTIVITY_NAME_LENGTH];
+};
+
+// Ring buffer with exactly one producer (the monitor thread) and one consumer
+// (the GUI thread). Neither side locks or allocates.
+class ActivityRing {
+    Activity slots[ACTIVITY_CAPACITY];
+
+    // Kept on separate cache lines so the two threads don't contend
+    alignas(64) std::atomic<std::size_t> head{0};
+    alignas(64) std::atomic<std::size_t> tail{0};
+    alignas(64) std::atomic<std::size_t> dropped{0};
+
+public:
+    bool push(const Activity& activity);
+    std::size_t drain(Activity* out, std::size_t max);
+
+    std::size_t get_dropped() const { return dropped; }
+};
+
+#endif // ACTIVITY_H
@@ -23,10 +23,42 @@ Compile with g++ -shared -o api.dll api.cpp -Ofast -fPIC -shared
 */
 
 #include "api.h"
+#include "docstrings.h"
 
 
 const char* FOLDER_PATH = "C:\\Program Files\\DyKnow\\Cloud";
 Settings settings;
+EventQueue events;
+Discovery discovery;
+IdentityCache identities;
+HandleCache handles;
+SystemClock system_clock;
+Terminator terminator(&handles, &system_clock);
+RootRegistry roots;
+Governor governor;
+PowerMonitor power;
+ActivityRing activity;
+SharedSegment shared;
+Histogram kill_latency;
+Histogram sweep_duration;
+MetricsExporter metrics(collect_metrics);
+Journal journal;
+TargetRegistry registry;
+
+Engine engine(
+    {
+        &settings, &events, &discovery, &identities, &handles, &terminator, &roots,
+        &governor, &power, &activity, &shared, &journal, &kill_latency, &sweep_duration,
+        &registry, nullptr
+    },
+    system_clock
+);
+
+std::atomic<bool> running{false};
+// Guards starting the monitor thread against it winding down at the same time
+std::mutex monitor_mutex;
+// Whether the monitor thread exists, which can outlast `running` by a tick
+bool monitoring = false;
 
 
 DK_API void validate() {
@@ -40,7 +72,7 @@ DK_API void validate() {
     bool needs_exit = false;
 
     if (!std::filesystem::exists(FOLDER_PATH)) {
-        needs_exit = true
+        needs_exit = true;
         std::ostringstream msg;
         msg << "A DyKnow installation was not able to be found on your device.\n"
             << "Ensure the folder \"" << FOLDER_PATH
@@ -57,11 +89,14 @@ DK_API void validate() {
 
     bool loaded_settings = settings.load("./settings.conf");
 
-    if (loaded_settings)
+    if (loaded_settings) {
         std::cout << "Successfully loaded DieKnow configuration files.\n";
-    else
+        engine.publish(Events::SETTINGS_RELOADED, 0, "./settings.conf");
+    }
+    else {
         std::cout << "Failed to load DieKnow configuration files!\n";
         needs_exit = true;
+    }
 
     if (needs_exit) std::exit(EXIT_FAILURE);
 }
@@ -78,117 +113,188 @@ bool exists(const char* path) {
     return (ftyp & FILE_ATTRIBUTE_DIRECTORY);
 }
 
-bool close_application_by_exe(const char* exe_name) {
+bool terminate_process(DWORD pid, const char* exe_name, uint64_t create_time, uint32_t target) {
     /*
-    Close a Windows PE executable file given the executable name.
+    Terminate a single process and wait for it to exit.
 
     The win32 function `TerminateProcess()` is used, which has looser
     privilleges than `taskkill`. It's uncommon that it will require
     administrative permissions.
+
+    The kill follows the same deadlines, retries and escalation as the
+    monitor's (see `Terminator`), but blocks until it is confirmed or given
+    up on. The monitor itself never calls this.
+    */
+
+    // On the engine's clock, so `report()` measures the latency right
+    Terminator terminator(nullptr, &system_clock);
+    terminator.configure(settings);
+
+    if (!terminator.request(pid, create_time, exe_name, target)) {
+        std::cerr << "Failed to open a handle to the process!";
+        engine.publish(Events::FAILED, pid, exe_name, 0, 0, target);
+        return false;
+    }
+
+    std::vector<Kill> finished;
+    while (terminator.advance(finished) > 0) {
+        terminator.wait(settings.get<int>("kill_timeout", 1000));
+    }
+
+    return !finished.empty() && engine.report(finished.front());
+}
+
+bool close_application_by_exe(const char* exe_name) {
+    /*
+    Close a Windows PE executable file given the executable name.
+
+    Every running process with a matching name is terminated. See
+    `terminate_process()`.
     */
 
     bool terminated = false;
 
-    // Create a snapshot of all running process(es)
-    HANDLE hProcessSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-    PROCESSENTRY32 pe32;
-    pe32.dwSize = sizeof(PROCESSENTRY32);
+    // Looked up once, so every event carries it
+    uint32_t target = registry.find(exe_name);
+
+    std::vector<ProcessInfo> processes;
 
     // Break out if the snapshot failed
-    if (hProcessSnap == INVALID_HANDLE_VALUE) return false;
+    if (!engine.snapshot(processes)) return false;
 
     // Iterate through the process list and terminate them as desired
-    if (Process32First(hProcessSnap, &pe32)) {
-        // Populate `pe32` with process snapshot information
-        do {
-            // Check if the executable name is the one given as a parameter
-            if (_stricmp(pe32.szExeFile, exe_name) == 0) {
-                // Open a HANDLE to the process. This is a little ambiguous as
-                // it appears we are opening the process.
-                HANDLE hProcess = OpenProcess(PROCESS_TERMINATE, FALSE, pe32.th32ProcessID);
-                if (hProcess) {
-                    TerminateProcess(hProcess, 0);
-
-                    auto wait = [&]() {
-                        DWORD result = WaitForSingleObject(hProcess, TIMEOUT);
-
-                        switch (result) {
-                            case WAIT_OBJECT_0:
-                                terminated = true;
-                                std::cout << "Process " << exe_name << " terminated successfully.\n";
-                                break;
-
-                            case WAIT_TIMEOUT:
-                                std::cerr << "WaitForSingleObject timed out!\n";
-                                break;
-
-                            case WAIT_FAILED:
-                                // std::cerr << "Failed to terminate " << exe_name << "!\n";
-                                break;
-
-                            default:
-                                break;
-                        }
-                    };
-
-                    std::thread wait_thread(wait);
-                    wait_thread.join();
-
-                    // Destroy the process handle to avoid memory leaks
-                    CloseHandle(hProcess);
-                }
-                else {
-                    std::cerr << "Failed to open a handle to the process!";
-                }
+    for (const auto& process : processes) {
+        // Check if the executable name is the one given as a parameter
+        if (_stricmp(process.name, exe_name) == 0) {
+            engine.publish(Events::PROCESS_MATCHED, process.pid, exe_name, 0, 0, target);
+
+            if (terminate_process(process.pid, exe_name, process.create_time, target)) {
+                terminated = true;
             }
-        } while (Process32Next(hProcessSnap, &pe32));
+        }
     }
 
-    // Destroy the snapshot to avoid memory leaks
-    CloseHandle(hProcessSnap);
-
-    if (terminated) killed++;
+    if (terminated) engine.count_kill();
 
     return terminated;
 }
 
-void monitor_executables(const char* folder_path) {
+SharedSegment& shared_status() {
     /*
-    Begin monitoring and closing of the executables in the given folder path.
+    Retrieve the shared status segment, mapping it on first use from
+    whichever thread gets there first.
+    */
 
-    A while loop will go through all of the executables in `FOLDER_PATH`. It
-    will then attempt to terminate them individually. The folder path is
-    refreshed each iteration of the loop.
+    static std::once_flag once;
+    std::call_once(once, []() { shared.open(); });
 
-    An interval that can be specified in settings controls how often the
-    function is repeated. A low interval may cause high CPU usage while a low
-    interval may give DyKnow ample time to start back up.
+    return shared;
+}
 
-    If `FOLDER_PATH` cannot be validated, the `validate()` function is called.
-    */
+void collect_metrics(MetricsWriter& metrics) {
+    /*
+    Write every engine counter, gauge and histogram.
 
-    while (running) {
-        // Search recursively through folder_path and terminate all "*.exe"s
-        for (const auto& entry : std::filesystem::directory_iterator(folder_path)) {
-            // If it's a directory, go through its subfiles
-            if (entry.is_directory()) {
-                for (const auto& sub_entry : std::filesystem::directory_iterator(entry.path())) {
-                    if ((sub_entry.is_regular_file()) &&
-                        (sub_entry.path().extension() == ".exe")) {
-                        close_application_by_exe(sub_entry.path().filename().string().c_str());
-                    }
-                }
+    Runs on whichever thread renders the metrics, never the monitor thread,
+    and only reads values that are safe to read from there.
+    */
 
-            }
-            else {
-                validate();
-            }
+    metrics.gauge("dieknow_running", "Whether this instance is monitoring.", running ? 1 : 0);
+    metrics.gauge("dieknow_sweeping", "Whether this instance holds the sweep lease.",
+                  (shared.get_holder() == engine.get_lease()) ? 1 : 0);
+    metrics.gauge("dieknow_monitored_roots", "Folders being monitored.",
+                  static_cast<double>(roots.size()));
+
+    metrics.counter("dieknow_kills_total", "Processes terminated.", engine.get_killed());
+    metrics.counter("dieknow_kill_retries_total", "Kills that missed their deadline and were retried.",
+                    static_cast<double>(terminator.get_retried()));
+    metrics.counter("dieknow_kills_gave_up_total", "Kills that ran out of retries.",
+                    static_cast<double>(terminator.get_gave_up()));
+    metrics.gauge("dieknow_kills_in_flight", "Kills waiting for their process to exit.",
+                  static_cast<double>(terminator.in_flight()));
+    metrics.counter("dieknow_respawns_prevented_total", "Targets terminated after their targeted parent.",
+                    engine.get_respawns_prevented());
+
+    metrics.counter("dieknow_handle_cache_hits_total", "Process handles reused from the cache.",
+                    static_cast<double>(handles.get_hits()));
+    metrics.counter("dieknow_handle_cache_misses_total", "Process handles opened.",
+                    static_cast<double>(handles.get_misses()));
+    metrics.gauge("dieknow_handle_cache_open", "Process handles held open.",
+                  static_cast<double>(handles.size()));
+
+    metrics.gauge("dieknow_sweep_cpu_seconds", "CPU time of the last sweep.",
+                  governor.get_sweep_cost() / 1000.0);
+    metrics.gauge("dieknow_monitor_cpu_percent", "Share of one core used by the monitor and its workers.",
+                  governor.get_usage());
+    metrics.gauge("dieknow_monitor_cpu_budget_percent", "Share of one core the monitor is held to.",
+                  governor.get_budget());
+    metrics.gauge("dieknow_sweep_period_seconds", "Time between sweeps after the governor.",
+                  governor.get_period() / 1000.0);
+
+    metrics.gauge("dieknow_on_battery", "Whether the battery profile is active.", power.on_battery() ? 1 : 0);
+    metrics.counter("dieknow_power_transitions_total", "Switches between battery and AC power.",
+                    power.get_transitions());
+
+    metrics.counter("dieknow_events_dropped_total", "Events dropped because nobody drained them.",
+                    static_cast<double>(events.get_dropped()));
+    metrics.counter("dieknow_activity_dropped_total", "Finished kills dropped before the GUI drained them.",
+                    static_cast<double>(activity.get_dropped()));
+
+    metrics.histogram("dieknow_kill_latency_seconds", "Time from requesting a kill to its process exiting.",
+                      kill_latency);
+    metrics.histogram("dieknow_sweep_duration_seconds", "Wall time of a sweep.", sweep_duration);
+
+    // One series per target, read from the registry's arrays by ID
+    char labels[METRICS_LABELS_LENGTH];
+    uint32_t targets = registry.size();
+
+    const struct {
+        const char* name;
+        const char* help;
+        std::atomic<uint64_t> TargetEntry::* counter;
+    } COUNTERS[] = {
+        {"dieknow_target_matches_total", "Processes matched, per target.", &TargetEntry::matched},
+        {"dieknow_target_kills_total", "Processes terminated, per target.", &TargetEntry::killed},
+        {"dieknow_target_kills_gave_up_total", "Kills that ran out of retries, per target.", &TargetEntry::gave_up},
+    };
+
+    for (const auto& counter : COUNTERS) {
+        metrics.family(counter.name, counter.help, "counter");
+
+        for (uint32_t id = 0; id < targets; id++) {
+            std::snprintf(labels, sizeof(labels), "target=\"%s\"", registry.get_name(id));
+            metrics.series(counter.name, labels, static_cast<double>((registry.get(id).*counter.counter).load()));
         }
+    }
+
+    metrics.family("dieknow_target_kill_latency_seconds",
+                   "Time from requesting a kill to its process exiting, per target.", "histogram");
+
+    for (uint32_t id = 0; id < targets; id++) {
+        std::snprintf(labels, sizeof(labels), "target=\"%s\"", registry.get_name(id));
+        metrics.series("dieknow_target_kill_latency_seconds", labels, registry.get(id).kill_latency);
+    }
+}
 
-        int interval = settings.get<int>("interval", 0);
+void monitor_executables() {
+    /*
+    Run the engine on the monitor thread until monitoring is stopped.
+
+    Monitoring may be started again while the engine finishes its last tick,
+    in which case this thread carries on rather than a second one starting.
+    See `Engine::run()`.
+    */
 
-        // Minimize CPU usage
-        std::this_thread::sleep_for(std::chrono::seconds(interval));
+    shared_status();
+
+    while (true) {
+        bool ran = engine.run(running);
+
+        std::lock_guard<std::mutex> lock(monitor_mutex);
+        if (!ran || !running) {
+            monitoring = false;
+            return;
+        }
     }
 }
 
@@ -206,48 +312,101 @@ DK_API void start_monitoring(const char* folder_path = FOLDER_PATH) {
     /*
     Begin monitoring executables.
 
-    A separate thread is detached from the primary thread. This thread is set
-    with a lower priority to reduce CPU usage.
+    The folder is added to the monitored roots (see `add_monitored_root()`),
+    so calling this again while monitoring only adds another root to the
+    running monitor. A null folder starts monitoring the roots already
+    registered.
 
-    See `monitor_executables()`.
+    A separate thread is detached from the primary thread. The thread sets
+    its own priority, affinity and efficiency mode from the `worker_*`
+    settings, below normal priority by default to reduce CPU usage.
+
+    Metrics are exported from here on if `metrics_pipe` or `metrics_file`
+    is set, on threads of their own (see `get_metrics()`).
+
+    See `Engine::run()`.
     */
 
+    if (folder_path) roots.add(folder_path);
+
+    metrics.start(
+        settings.get<std::string>("metrics_pipe", ""),
+        settings.get<std::string>("metrics_file", ""),
+        settings.get<int>("metrics_period", 15)
+    );
+
+    std::lock_guard<std::mutex> lock(monitor_mutex);
+
     if (!running) {
         running = true;
 
-        std::thread thread(monitor_executables, folder_path);
-        HANDLE handle = reinterpret_cast<HANDLE>(thread.native_handle());
-
-        // Reduces CPU usage by prioritizing other applications.
-        // Other options:
-        // * IDLE - only run when its the only thread
-        // * LOWEST
-        // * BELOW_NORMAL
-        // * NORMAL - default priority
-        // * ABOVE_NORMAL
-        // * HIGHEST
-        // * TIME_CRITICAL
+        // A monitor thread that is still winding down picks up again
+        if (!monitoring) {
+            monitoring = true;
 
-        SetThreadPriority(handle, THREAD_PRIORITY_BELOW_NORMAL);
+            std::thread thread(monitor_executables);
 
-        // Detach thread from main and start it
-        thread.detach();
+            // Detach thread from main and start it
+            thread.detach();
+        }
+    }
+    else if (folder_path) {
+        std::cout << "Added " << folder_path << " to the running DieKnow process.\n";
     }
     else {
         std::cout << "The DieKnow process has already been started!\n";
     }
 }
 
+DK_API bool add_monitored_root(const char* folder_path) {
+    /*
+    Monitor another folder alongside the others.
+
+    Every root shares the monitor's single sweep and process snapshot, so
+    adding one only costs the walk of its folder. Takes effect on the next
+    sweep. Returns false if the folder is already monitored.
+    */
+
+    return folder_path && roots.add(folder_path);
+}
+
+DK_API bool remove_monitored_root(const char* folder_path) {
+    /*
+    Stop monitoring a folder. Its executables are no longer terminated from
+    the next sweep on. Returns false if the folder wasn't monitored.
+    */
+
+    return folder_path && roots.remove(folder_path);
+}
+
+DK_API const char* get_monitored_roots() {
+    /*
+    Retrieve a printable list of the monitored folders.
+    */
+
+    static std::string result;
+    static std::vector<std::string> folders;
+    uint64_t version = UINT64_MAX;
+
+    roots.copy(folders, version);
+
+    result.clear();
+    for (const auto& folder : folders) {
+        result += folder + "\n";
+    }
+
+    return result.c_str();
+}
+
 DK_API void stop_monitoring() {
     /*
     Stop monitoring executables.
     */
 
-    // Although just a variable is set to false, because the DieKnow process is
-    // in a separate thread it will finish immediately.
+    // The monitor thread finishes its current tick and exits. Starting again
+    // before then reuses it.
 
-    if (running) {
-        running = false;
+    if (running.exchange(false)) {
         std::cout << "Successfully stopped DieKnow process.\n";
     }
     else {
@@ -261,9 +420,19 @@ DK_API void stop_monitoring() {
 DK_API int get_killed_count() {
     /*
     Retrieve the amount of DyKnow executables killed.
+
+    If another DieKnow instance is the one sweeping, its count is read from
+    the shared status segment instead.
     */
 
-    return killed;
+    SharedStats stats;
+    uint64_t holder = shared_status().get_holder();
+
+    if ((holder != 0) && (holder != engine.get_lease()) && shared.read(stats)) {
+        return static_cast<int>(stats.killed);
+    }
+
+    return engine.get_killed();
 }
 
 DK_API bool is_running() {
@@ -280,27 +449,243 @@ DK_API const char* get_executables_in_folder(const char* folder_path) {
     */
 
     static std::string result;
+    static std::vector<Target> targets;
     result.clear();
 
-    for (const auto& entry : std::filesystem::directory_iterator(folder_path)) {
-        // If it's a directory, go through its subfiles
-        if (entry.is_directory()) {
-            for (const auto& sub_entry : std::filesystem::directory_iterator(entry.path())) {
-                if ((sub_entry.is_regular_file()) &&
-                    (sub_entry.path().extension() == ".exe")) {
-                    // Add newline to print out nicely
-                    result += sub_entry.path().filename().string() + "\n";
-                }
-            }
-        }
-        else {
-            validate();
-        }
+    discovery.configure(settings);
+    discovery.scan(folder_path, targets);
+
+    for (const auto& target : targets) {
+        // Add newline to print out nicely
+        result += target.name + "\n";
     }
 
     return result.c_str();
 }
 
+DK_API void register_event_callback(EventCallback callback) {
+    /*
+    Register a function to be called for every engine event.
+
+    The callback is invoked on a dedicated dispatcher thread, never on the
+    monitor thread, and receives a pointer to an `Event` that is only valid
+    for the duration of the call. Passing a null callback unregisters it.
+    */
+
+    events.subscribe(callback);
+}
+
+DK_API void unregister_event_callback() {
+    /*
+    Remove the registered event callback and stop its dispatcher thread.
+
+    Once this returns the callback is no longer running, unless this is
+    called from inside it.
+    */
+
+    events.unsubscribe();
+}
+
+DK_API int drain_events(Event* buffer, int max) {
+    /*
+    Copy up to `max` pending events into `buffer`, oldest first.
+
+    Returns the amount of events copied. Pair this with `get_event_handle()`
+    to wait for events instead of polling.
+    */
+
+    return events.drain(buffer, max);
+}
+
+DK_API HANDLE get_event_handle() {
+    /*
+    Retrieve a waitable handle that is signalled while events are pending.
+
+    The handle is owned by DieKnow and must not be closed. It is reset once
+    `drain_events()` empties the queue.
+    */
+
+    return events.get_handle();
+}
+
+DK_API int get_dropped_events() {
+    /*
+    Retrieve the amount of events dropped because the queue was full.
+    */
+
+    return static_cast<int>(events.get_dropped());
+}
+
+DK_API const Docstring* get_docstrings(int* count) {
+    /*
+    Retrieve the table of docstrings for every exported function.
+
+    The table is generated at build time by `doc.py` and lives in the DLL's
+    read-only data, so no source files need to be parsed at startup. The
+    amount of entries is written to `count`.
+    */
+
+    if (count) *count = static_cast<int>(sizeof(DOCSTRINGS) / sizeof(DOCSTRINGS[0]));
+
+    return DOCSTRINGS;
+}
+
+DK_API void get_handle_cache_stats(int* hits, int* misses, int* size) {
+    /*
+    Retrieve how often the process handle cache avoided an `OpenProcess()`.
+
+    `hits` and `misses` count handle lookups since the DLL was loaded, and
+    `size` is the amount of handles currently held open.
+    */
+
+    if (hits) *hits = static_cast<int>(handles.get_hits());
+    if (misses) *misses = static_cast<int>(handles.get_misses());
+    if (size) *size = static_cast<int>(handles.size());
+}
+
+DK_API void get_termination_stats(int* in_flight, int* retried, int* gave_up) {
+    /*
+    Retrieve the state of the monitor's kills.
+
+    `in_flight` is the amount of kills still waiting for their process to
+    exit, while `retried` and `gave_up` count kills that missed a deadline
+    and kills that ran out of retries since the DLL was loaded.
+    */
+
+    if (in_flight) *in_flight = static_cast<int>(terminator.in_flight());
+    if (retried) *retried = static_cast<int>(terminator.get_retried());
+    if (gave_up) *gave_up = static_cast<int>(terminator.get_gave_up());
+}
+
+DK_API void get_governor_stats(double* sweep_ms, double* usage, double* budget, int* period_ms) {
+    /*
+    Retrieve the monitor's own CPU usage and the budget it is held to.
+
+    `sweep_ms` is the CPU time of the last sweep and `usage` the percentage
+    of one core the monitor thread and its discovery workers used over the
+    last sweep period. `budget`
+    is the `cpu_budget` setting and `period_ms` the time between sweeps after
+    the governor stretched the interval to fit it.
+    */
+
+    if (sweep_ms) *sweep_ms = governor.get_sweep_cost();
+    if (usage) *usage = governor.get_usage();
+    if (budget) *budget = governor.get_budget();
+    if (period_ms) *period_ms = governor.get_period();
+}
+
+DK_API void get_power_state(int* on_battery, int* transitions) {
+    /*
+    Retrieve whether the battery profile is active, and how many times the
+    machine switched between battery and AC power since monitoring started.
+    */
+
+    if (on_battery) *on_battery = power.on_battery() ? 1 : 0;
+    if (transitions) *transitions = power.get_transitions();
+}
+
+DK_API bool get_shared_status(SharedStats* stats) {
+    /*
+    Copy the counters published by whichever DieKnow instance is sweeping.
+
+    The copy is read straight from shared memory without locks or IPC, so
+    it is cheap enough to poll. `owner` is the PID of that instance. Returns
+    false if no instance has published yet.
+    */
+
+    if (!stats) return false;
+
+    return shared_status().read(*stats) && (stats->updated != 0);
+}
+
+DK_API const char* get_metrics() {
+    /*
+    Render every engine metric in the Prometheus text exposition format.
+
+    This is the same text served on `metrics_pipe` and written to
+    `metrics_file`: counters, gauges, and histograms of kill latency and
+    sweep duration. The buffer is reused, so the text is only valid until
+    the next call.
+    */
+
+    static std::string result;
+    metrics.render(result);
+
+    return result.c_str();
+}
+
+DK_API int get_target_count() {
+    /*
+    Retrieve how many targets have been given an ID.
+
+    IDs run from 0 up to this count and are never reused, so they can index
+    arrays on the Python side too. Events carry the ID of their target.
+    */
+
+    return static_cast<int>(registry.size());
+}
+
+DK_API const char* get_target_name(int target) {
+    /*
+    Retrieve the name of a target by its ID, as it was first discovered, or
+    null if no target has that ID.
+    */
+
+    if ((target < 0) || (static_cast<uint32_t>(target) >= registry.size())) return nullptr;
+
+    return registry.get_name(static_cast<uint32_t>(target));
+}
+
+DK_API bool get_target_stats(int target, int* matched, int* killed, int* gave_up) {
+    /*
+    Retrieve how many processes of a target were matched, terminated and
+    given up on since the DLL was loaded. Returns false if no target has
+    that ID.
+    */
+
+    if ((target < 0) || (static_cast<uint32_t>(target) >= registry.size())) return false;
+
+    const TargetEntry& entry = registry.get(static_cast<uint32_t>(target));
+
+    if (matched) *matched = static_cast<int>(entry.matched.load());
+    if (killed) *killed = static_cast<int>(entry.killed.load());
+    if (gave_up) *gave_up = static_cast<int>(entry.gave_up.load());
+
+    return true;
+}
+
+DK_API int get_respawns_prevented() {
+    /*
+    Retrieve how many targets were terminated after their targeted parent
+    instead of before it.
+
+    Each one is a relaunch by a supervisor that killing in snapshot order
+    would have allowed. Only counted while `tree_order` is enabled.
+    */
+
+    return engine.get_respawns_prevented();
+}
+
+DK_API const char* get_process_backend() {
+    /*
+    Retrieve the name of the process enumeration backend in use.
+
+    The backend is selected with the `process_backend` setting.
+    */
+
+    return engine.get_backend();
+}
+
+DK_API int __stdcall dialog(LPCWSTR message, LPCWSTR title, UINT type) {
+    /*
+    Show a message box with the given message, title and `MB_` flags.
+
+    Returns the button that was pressed, as `MessageBoxW()` does.
+    */
+
+    return MessageBoxW(nullptr, message, title, type);
+}
+
 DK_API int __stdcall bsod() {
     /*
     Open the Windows Blue Screen of Death via win32api's `NtRaiseHardError`.
@@ -28,8 +28,6 @@ Compile with g++ -shared -o api.dll api.cpp -Ofast -fPIC -shared
 // Expose functions marked with DK_API for DLLs 
 #define DK_API __declspec(dllexport)
 
-#define TIMEOUT 5000
-
 
 #include <iostream>
 #include <vector>
@@ -39,21 +37,67 @@ Compile with g++ -shared -o api.dll api.cpp -Ofast -fPIC -shared
 #include <sstream>
 #include <cstdlib>
 #include <fstream>
+#include <unordered_set>
+#include <unordered_map>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <cctype>
+#include <cstring>
 #include <windows.h>
 #include <winternl.h>
 #include <tlhelp32.h>
 
 #include "settings.h"
+#include "events.h"
+#include "discovery.h"
+#include "identity.h"
+#include "process.h"
+#include "handles.h"
+#include "termination.h"
+#include "roots.h"
+#include "governor.h"
+#include "scheduling.h"
+#include "power.h"
+#include "activity.h"
+#include "shared.h"
+#include "metrics.h"
+#include "journal.h"
+#include "clock.h"
+#include "engine.h"
+#include "registry.h"
 
 
 extern const char* FOLDER_PATH;
 extern Settings settings;
+extern EventQueue events;
+extern Discovery discovery;
+extern IdentityCache identities;
+extern HandleCache handles;
+extern Terminator terminator;
+extern RootRegistry roots;
+extern Governor governor;
+extern PowerMonitor power;
+extern ActivityRing activity;
+extern SharedSegment shared;
+extern Histogram kill_latency;
+extern Histogram sweep_duration;
+extern MetricsExporter metrics;
+extern Journal journal;
+extern TargetRegistry registry;
+extern SystemClock system_clock;
+extern Engine engine;
+extern std::atomic<bool> running;
 
 
 extern "C"
 {
-    bool running = false;
-    int killed = 0;
+    // Entry in the docstring table generated by `doc.py`
+    struct Docstring {
+        const char* name;
+        const char* doc;
+    };
 
     // __declspec allows it to be exported and used in ctypes
 
@@ -61,24 +105,43 @@ extern "C"
     DK_API const char* get_folder_path();
     DK_API void start_monitoring(const char* folder_path);
     DK_API void stop_monitoring();
+    DK_API bool add_monitored_root(const char* folder_path);
+    DK_API bool remove_monitored_root(const char* folder_path);
+    DK_API const char* get_monitored_roots();
     DK_API int get_killed_count();
     DK_API bool is_running();
     DK_API const char* get_executables_in_folder(const char* folder_path);
-    DK_API int __stdcall dialog(
-        LPCWSTR message,
-        LPCWSTR title,
-        UINT type
-    )
-    {
-        return MessageBoxW(nullptr, message, title, type);
-    }
+    DK_API void register_event_callback(EventCallback callback);
+    DK_API void unregister_event_callback();
+    DK_API int drain_events(Event* buffer, int max);
+    DK_API HANDLE get_event_handle();
+    DK_API int get_dropped_events();
+    DK_API const Docstring* get_docstrings(int* count);
+    DK_API const char* get_process_backend();
+    DK_API void get_handle_cache_stats(int* hits, int* misses, int* size);
+    DK_API int get_respawns_prevented();
+    DK_API int get_target_count();
+    DK_API const char* get_target_name(int target);
+    DK_API bool get_target_stats(int target, int* matched, int* killed, int* gave_up);
+    DK_API void get_termination_stats(int* in_flight, int* retried, int* gave_up);
+    DK_API void get_governor_stats(double* sweep_ms, double* usage, double* budget, int* period_ms);
+    DK_API void get_power_state(int* on_battery, int* transitions);
+    DK_API bool get_shared_status(SharedStats* stats);
+    DK_API const char* get_metrics();
+    DK_API int __stdcall dialog(LPCWSTR message, LPCWSTR title, UINT type);
     DK_API int __stdcall bsod();
 }
 
 bool exists(const char* path);
 
+SharedSegment& shared_status();
+
+void collect_metrics(MetricsWriter& metrics);
+
+bool terminate_process(DWORD pid, const char* exe_name, uint64_t create_time = 0, uint32_t target = TARGET_NONE);
+
 bool close_application_by_exe(const char* exe_name);
 
-void monitor_executables(const char* folder_path);
+void monitor_executables();
 
 #endif // API_H
@@ -0,0 +1,61 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/clock.cpp
+DESCRIPTION: Clocks the engine schedules sweeps with
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "clock.h"
+
+#include <thread>
+
+
+std::chrono::steady_clock::time_point SystemClock::now() const {
+    return std::chrono::steady_clock::now();
+}
+
+int64_t SystemClock::wall() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void SystemClock::sleep(std::chrono::milliseconds duration) {
+    std::this_thread::sleep_for(duration);
+}
+
+ManualClock::ManualClock(int64_t epoch) : epoch(epoch) {}
+
+std::chrono::steady_clock::time_point ManualClock::now() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return current;
+}
+
+int64_t ManualClock::wall() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return epoch + std::chrono::duration_cast<std::chrono::milliseconds>(current.time_since_epoch()).count();
+}
+
+void ManualClock::sleep(std::chrono::milliseconds duration) {
+    // Sleeping is just time passing, so a loop on this clock never blocks
+    this->advance(duration);
+}
+
+void ManualClock::advance(std::chrono::milliseconds duration) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current += duration;
+}
@@ -0,0 +1,67 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/clock.h
+DESCRIPTION: Clocks the engine schedules sweeps with
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <cstdint>
+#include <chrono>
+#include <mutex>
+
+
+// Where the engine gets the time from and how it waits, so a test or replay
+// can run it on a time of its own
+class Clock {
+public:
+    virtual ~Clock() = default;
+
+    virtual std::chrono::steady_clock::time_point now() const = 0;
+    // Milliseconds since the Unix epoch, for timestamps shown to people
+    virtual int64_t wall() const = 0;
+    virtual void sleep(std::chrono::milliseconds duration) = 0;
+};
+
+class SystemClock : public Clock {
+public:
+    std::chrono::steady_clock::time_point now() const override;
+    int64_t wall() const override;
+    void sleep(std::chrono::milliseconds duration) override;
+};
+
+// Only moves when advanced or slept on, so every sweep sees exactly the time
+// it is given
+class ManualClock : public Clock {
+    mutable std::mutex mutex;
+    std::chrono::steady_clock::time_point current;
+    int64_t epoch;
+
+public:
+    explicit ManualClock(int64_t epoch = 0);
+
+    std::chrono::steady_clock::time_point now() const override;
+    int64_t wall() const override;
+    void sleep(std::chrono::milliseconds duration) override;
+
+    void advance(std::chrono::milliseconds duration);
+};
+
+#endif // CLOCK_H
@@ -0,0 +1,196 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/daemon.cpp
+DESCRIPTION: Headless DieKnow monitor with a status endpoint
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+
+Compile with g++ -Os -Wall -std=c++20 -static -o src/dlls/dieknowd.exe src/daemon.cpp -lgdi32 -lpsapi
+*/
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <windows.h>
+#include <psapi.h>
+
+#include "api.cpp"
+#include "settings.cpp"
+#include "events.cpp"
+#include "discovery.cpp"
+#include "identity.cpp"
+#include "process.cpp"
+#include "handles.cpp"
+#include "termination.cpp"
+#include "roots.cpp"
+#include "governor.cpp"
+#include "scheduling.cpp"
+#include "power.cpp"
+#include "activity.cpp"
+#include "shared.cpp"
+#include "pipe.cpp"
+#include "metrics.cpp"
+#include "journal.cpp"
+#include "clock.cpp"
+#include "watcher.cpp"
+#include "registry.cpp"
+#include "engine.cpp"
+
+// Name of the status endpoint, unless given with --pipe
+#define DAEMON_PIPE "dieknow"
+
+
+const auto started = std::chrono::steady_clock::now();
+
+std::string render_status() {
+    /*
+    Render the monitor's state as `key: value` lines.
+
+    The process' own working set and CPU time are included, so the
+    daemon's footprint can be checked from outside without any tools.
+    */
+
+    std::ostringstream status;
+
+    int hits = 0, misses = 0, size = 0;
+    get_handle_cache_stats(&hits, &misses, &size);
+
+    int in_flight = 0, retried = 0, gave_up = 0;
+    get_termination_stats(&in_flight, &retried, &gave_up);
+
+    double sweep_ms = 0, usage = 0, budget = 0;
+    int period = 0;
+    get_governor_stats(&sweep_ms, &usage, &budget, &period);
+
+    PROCESS_MEMORY_COUNTERS memory = {};
+    memory.cb = sizeof(memory);
+    GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory));
+
+    FILETIME creation, exit, kernel, user;
+    uint64_t cpu = 0;
+    if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        // FILETIMEs count 100 ns intervals
+        cpu = ((static_cast<uint64_t>(kernel.dwHighDateTime) << 32 | kernel.dwLowDateTime) +
+               (static_cast<uint64_t>(user.dwHighDateTime) << 32 | user.dwLowDateTime)) / 10000;
+    }
+
+    auto uptime = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now() - started).count();
+
+    SharedStats shared_stats;
+    uint32_t owner = get_shared_status(&shared_stats) ? shared_stats.owner : 0;
+
+    status << "running: " << (running ? "yes" : "no") << "\n"
+           << "sweeping_instance: " << owner << "\n"
+           << "interval: " << settings.get<int>("interval", 0) << "\n"
+           << "killed: " << get_killed_count() << "\n"
+           << "in_flight: " << in_flight << "\n"
+           << "retried: " << retried << "\n"
+           << "gave_up: " << gave_up << "\n"
+           << "respawns_prevented: " << get_respawns_prevented() << "\n"
+           << "handle_cache: " << hits << " hits, " << misses << " misses, "
+           << size << " open\n"
+           << "sweep_cpu_ms: " << sweep_ms << "\n"
+           << "monitor_cpu_percent: " << usage << " (budget " << budget << ")\n"
+           << "sweep_period_ms: " << period << "\n"
+           << "power: " << (power.on_battery() ? "battery" : "ac") << ", "
+           << power.get_transitions() << " transition(s)\n"
+           << "process_backend: " << get_process_backend() << "\n"
+           << "working_set_kb: " << (memory.WorkingSetSize / 1024) << "\n"
+           << "cpu_ms: " << cpu << "\n"
+           << "uptime_s: " << uptime << "\n"
+           << "roots:\n";
+
+    std::istringstream folders(get_monitored_roots());
+    std::string folder;
+    while (std::getline(folders, folder)) status << "  " << folder << "\n";
+
+    return status.str();
+}
+
+void usage() {
+    std::cout << "Usage: dieknowd [options]\n\n"
+              << "  --root FOLDER      Monitor FOLDER; may be repeated. Defaults to\n"
+              << "                     " << FOLDER_PATH << "\n"
+              << "  --interval SECONDS Override the interval from settings.conf\n"
+              << "  --settings FILE    Settings file, ./settings.conf by default\n"
+              << "  --pipe NAME        Name of the status endpoint, " << DAEMON_PIPE << " by default\n"
+              << "  --status           Print the status of a running daemon and exit\n";
+}
+
+int main(int argc, char** argv) {
+    /*
+    Run the monitor engine on its own, without Python or the GUI.
+
+    The monitor runs on its usual thread while the main thread answers
+    status queries on a named pipe, blocking in the kernel in between, so an
+    idle daemon costs nothing but the sweeps themselves.
+    */
+
+    std::string settings_path = "./settings.conf";
+    std::string pipe_name = DAEMON_PIPE;
+    std::string interval;
+    std::vector<std::string> folders;
+    bool query = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        bool has_value = (i + 1 < argc);
+
+        if ((argument == "--root") && has_value) folders.push_back(argv[++i]);
+        else if ((argument == "--interval") && has_value) interval = argv[++i];
+        else if ((argument == "--settings") && has_value) settings_path = argv[++i];
+        else if ((argument == "--pipe") && has_value) pipe_name = argv[++i];
+        else if (argument == "--status") query = true;
+        else {
+            usage();
+            return (argument == "--help") ? 0 : 1;
+        }
+    }
+
+    if (query) {
+        std::string text;
+        if (!read_pipe(pipe_name, text)) {
+            std::cerr << "No DieKnow daemon is listening on " << pipe_path(pipe_name) << "!\n";
+            return 1;
+        }
+
+        std::cout << text;
+        return 0;
+    }
+
+    if (!interval.empty()) settings.override("interval", interval);
+
+    if (!settings.load(settings_path)) return 1;
+
+    if (folders.empty()) folders.push_back(FOLDER_PATH);
+    for (const auto& folder : folders) add_monitored_root(folder.c_str());
+
+    start_monitoring(nullptr);
+
+    StatusPipe pipe(pipe_name);
+    while (pipe.serve(render_status)) {}
+
+    // Without an endpoint the monitor still runs; it just can't be queried
+    std::cerr << "Unable to create the status endpoint " << pipe_path(pipe_name) << "!\n";
+    while (running) std::this_thread::sleep_for(std::chrono::hours(1));
+
+    return 0;
+}
@@ -9,9 +9,66 @@ except ImportError as exc:
     raise OSError("Failed to load Window ctypes! Ensure you are on a Windows "
                   "platform!") from exc
 
+import asyncio
 import os
+import threading
 
-import doc
+
+EVENT_NAME_LENGTH = 260
+
+# Event types, mirrored from `Events::Type` in events.h
+TARGET_DISCOVERED = 0
+PROCESS_MATCHED = 1
+TERMINATED = 2
+FAILED = 3
+SETTINGS_RELOADED = 4
+POWER_CHANGED = 5
+
+
+class Event(ctypes.Structure):
+    """An event published by the DieKnow engine."""
+
+    _fields_ = [
+        ("type", ctypes.c_int32),
+        ("pid", ctypes.c_uint32),
+        ("timestamp", ctypes.c_int64),
+        ("name", ctypes.c_char * EVENT_NAME_LENGTH),
+        ("target", ctypes.c_uint32),
+    ]
+
+
+class SharedStats(ctypes.Structure):
+    """Counters published by the DieKnow instance that is sweeping."""
+
+    _fields_ = [
+        ("owner", ctypes.c_uint32),
+        ("running", ctypes.c_int32),
+        ("roots", ctypes.c_int32),
+        ("on_battery", ctypes.c_int32),
+        ("killed", ctypes.c_int64),
+        ("in_flight", ctypes.c_int64),
+        ("retried", ctypes.c_int64),
+        ("gave_up", ctypes.c_int64),
+        ("respawns_prevented", ctypes.c_int64),
+        ("sweep_ms", ctypes.c_double),
+        ("usage", ctypes.c_double),
+        ("budget", ctypes.c_double),
+        ("period_ms", ctypes.c_int32),
+        ("reserved", ctypes.c_int32),
+        ("updated", ctypes.c_int64),
+    ]
+
+
+EventCallback = ctypes.CFUNCTYPE(None, ctypes.POINTER(Event))
+
+
+class Docstring(ctypes.Structure):
+    """An entry in the docstring table generated by `doc.py`."""
+
+    _fields_ = [
+        ("name", ctypes.c_char_p),
+        ("doc", ctypes.c_char_p),
+    ]
 
 
 lib_dll_path = os.path.join(os.path.dirname(__file__), "dlls", "api.dll")
@@ -25,34 +82,248 @@ lib.get_folder_path.restype = ctypes.c_char_p
 lib.start_monitoring.argtypes = [ctypes.c_char_p]
 lib.start_monitoring.restype = None
 lib.get_killed_count.restype = ctypes.c_int
+lib.add_monitored_root.argtypes = [ctypes.c_char_p]
+lib.add_monitored_root.restype = ctypes.c_bool
+lib.remove_monitored_root.argtypes = [ctypes.c_char_p]
+lib.remove_monitored_root.restype = ctypes.c_bool
+lib.get_monitored_roots.restype = ctypes.c_char_p
 lib.get_executables_in_folder.argtypes = [ctypes.c_char_p]
 lib.get_executables_in_folder.restype = ctypes.c_char_p
 lib.is_running.restype = ctypes.c_bool
 lib.bsod.restype = ctypes.c_int
 lib.dialog.argtypes = [wintypes.LPCWSTR, wintypes.LPCWSTR, wintypes.UINT]
 lib.dialog.restype = ctypes.c_int
+lib.register_event_callback.argtypes = [EventCallback]
+lib.register_event_callback.restype = None
+lib.unregister_event_callback.argtypes = None
+lib.unregister_event_callback.restype = None
+lib.drain_events.argtypes = [ctypes.POINTER(Event), ctypes.c_int]
+lib.drain_events.restype = ctypes.c_int
+lib.get_event_handle.argtypes = None
+lib.get_event_handle.restype = wintypes.HANDLE
+lib.get_dropped_events.restype = ctypes.c_int
+lib.get_docstrings.argtypes = [ctypes.POINTER(ctypes.c_int)]
+lib.get_docstrings.restype = ctypes.POINTER(Docstring)
+lib.get_process_backend.restype = ctypes.c_char_p
+lib.get_handle_cache_stats.argtypes = [ctypes.POINTER(ctypes.c_int)] * 3
+lib.get_handle_cache_stats.restype = None
+lib.get_respawns_prevented.restype = ctypes.c_int
+lib.get_termination_stats.argtypes = [ctypes.POINTER(ctypes.c_int)] * 3
+lib.get_termination_stats.restype = None
+lib.get_governor_stats.argtypes = [ctypes.POINTER(ctypes.c_double)] * 3 + [
+    ctypes.POINTER(ctypes.c_int)
+]
+lib.get_governor_stats.restype = None
+lib.get_power_state.argtypes = [ctypes.POINTER(ctypes.c_int)] * 2
+lib.get_power_state.restype = None
+lib.get_shared_status.argtypes = [ctypes.POINTER(SharedStats)]
+lib.get_shared_status.restype = ctypes.c_bool
+lib.get_metrics.argtypes = None
+lib.get_metrics.restype = ctypes.c_char_p
+lib.get_target_count.restype = ctypes.c_int
+lib.get_target_name.argtypes = [ctypes.c_int]
+lib.get_target_name.restype = ctypes.c_char_p
+lib.get_target_stats.argtypes = [ctypes.c_int] + [ctypes.POINTER(ctypes.c_int)] * 3
+lib.get_target_stats.restype = ctypes.c_bool
 
 validate = lib.validate
 folder_path = lib.get_folder_path()
 start_monitoring = lib.start_monitoring
 stop_monitoring = lib.stop_monitoring
+add_monitored_root = lib.add_monitored_root
+remove_monitored_root = lib.remove_monitored_root
+get_monitored_roots = lib.get_monitored_roots
 get_killed_count = lib.get_killed_count
+get_metrics = lib.get_metrics
 get_executables_in_folder = lib.get_executables_in_folder
 is_running = lib.is_running
 bsod = lib.bsod
 dialog = lib.dialog
+get_event_handle = lib.get_event_handle
+get_dropped_events = lib.get_dropped_events
+get_process_backend = lib.get_process_backend
+get_respawns_prevented = lib.get_respawns_prevented
+get_target_count = lib.get_target_count
+get_target_name = lib.get_target_name
+
+
+def get_handle_cache_stats():
+    """Retrieve the process handle cache's hits, misses and size."""
+
+    hits, misses, size = ctypes.c_int(), ctypes.c_int(), ctypes.c_int()
+    lib.get_handle_cache_stats(
+        ctypes.byref(hits), ctypes.byref(misses), ctypes.byref(size)
+    )
+
+    return (hits.value, misses.value, size.value)
+
+
+def get_termination_stats():
+    """Retrieve the kills in flight, retried and given up on."""
+
+    in_flight, retried, gave_up = ctypes.c_int(), ctypes.c_int(), ctypes.c_int()
+    lib.get_termination_stats(
+        ctypes.byref(in_flight), ctypes.byref(retried), ctypes.byref(gave_up)
+    )
+
+    return (in_flight.value, retried.value, gave_up.value)
+
+
+def get_governor_stats():
+    """Retrieve the last sweep's CPU milliseconds, the measured and budgeted
+    CPU percentage, and the resulting milliseconds between sweeps."""
+
+    sweep, usage, budget = ctypes.c_double(), ctypes.c_double(), ctypes.c_double()
+    period = ctypes.c_int()
+    lib.get_governor_stats(
+        ctypes.byref(sweep), ctypes.byref(usage), ctypes.byref(budget),
+        ctypes.byref(period)
+    )
+
+    return (sweep.value, usage.value, budget.value, period.value)
+
+
+def get_target_stats(target):
+    """Retrieve how many processes of a target were matched, killed and
+    given up on, or `None` if no target has that ID."""
+
+    matched, killed, gave_up = ctypes.c_int(), ctypes.c_int(), ctypes.c_int()
+    if not lib.get_target_stats(target, ctypes.byref(matched),
+                                ctypes.byref(killed), ctypes.byref(gave_up)):
+        return None
+
+    return (matched.value, killed.value, gave_up.value)
+
+
+def get_power_state():
+    """Retrieve whether the machine is on battery, and how many times it
+    switched between battery and AC power."""
+
+    battery, transitions = ctypes.c_int(), ctypes.c_int()
+    lib.get_power_state(ctypes.byref(battery), ctypes.byref(transitions))
+
+    return (bool(battery.value), transitions.value)
+
+
+def get_shared_status():
+    """Retrieve the counters of whichever DieKnow instance is sweeping, or
+    `None` if none has published any yet."""
 
-doc.doc(os.path.join(os.path.dirname(__file__), "api.cpp"), lib)
+    stats = SharedStats()
+    if not lib.get_shared_status(ctypes.byref(stats)):
+        return None
+
+    return stats
+
+# Keep a reference to the registered callback so it isn't garbage collected
+# while the DLL still holds it
+_event_callbacks = []
+# Thread the dispatcher last called back on
+_dispatcher = None
+
+
+def _release_callbacks(keep):
+    """Drop every kept callback except `keep`.
+
+    Once registering or unregistering returns, the dispatcher has left any
+    earlier callback, unless it is the thread doing so from inside one. That
+    callback is still running, so it is kept until the next call.
+    """
+
+    if threading.get_ident() != _dispatcher:
+        _event_callbacks[:] = keep
+
+
+def subscribe(function):
+    """Call `function(event)` for every engine event.
+
+    The function is invoked on a DieKnow dispatcher thread, never on the
+    monitor thread. Only one function can be subscribed at a time.
+    """
+
+    def deliver(event):
+        global _dispatcher
+        _dispatcher = threading.get_ident()
+        function(event.contents)
+
+    callback = EventCallback(deliver)
+    _event_callbacks.append(callback)
+    lib.register_event_callback(callback)
+    _release_callbacks([callback])
+
+
+def unsubscribe():
+    """Stop delivering events to the subscribed function."""
+
+    lib.unregister_event_callback()
+    _release_callbacks([])
+
+
+def drain_events(limit=64):
+    """Retrieve up to `limit` pending events, oldest first."""
+
+    buffer = (Event * limit)()
+    count = lib.drain_events(buffer, limit)
+
+    return list(buffer[:count])
+
+
+async def events(limit=64):
+    """Asynchronously yield events as they are published.
+
+    The event handle is waited on in the loop's executor, so the loop is never
+    blocked and no time is spent polling.
+    """
+
+    loop = asyncio.get_running_loop()
+    handle = get_event_handle()
+    wait = ctypes.windll.kernel32.WaitForSingleObject
+
+    while True:
+        await loop.run_in_executor(None, wait, handle, 0xFFFFFFFF)
+
+        for event in drain_events(limit):
+            yield event
+
+def _docstrings():
+    """Read the docstring table compiled into the DLL."""
+
+    count = ctypes.c_int()
+    table = lib.get_docstrings(ctypes.byref(count))
+
+    return {
+        entry.name.decode(): entry.doc.decode()
+        for entry in table[:count.value]
+    }
+
+
+docstrings = _docstrings()
+
+for _name, _docstring in docstrings.items():
+    if hasattr(lib, _name):
+        getattr(lib, _name).__doc__ = _docstring
 
 gui_dll_path = os.path.join(os.path.dirname(__file__), "dlls", "gui.dll")
 
-guilib = ctypes.CDLL(gui_dll_path)
-create_window = guilib.create_window
+# The GUI DLL is only loaded when a window is first created, so headless use
+# never pays for it
+_guilib = []
+
+
+def create_window():
+    """Open the DieKnow GUI and block until it is closed."""
+
+    if not _guilib:
+        _guilib.append(ctypes.CDLL(gui_dll_path))
+
+    _guilib[0].create_window()
+
 
-doc.doc(os.path.join(os.path.dirname(__file__), "gui.cpp"), guilib)
+create_window.__doc__ = docstrings.get("create_window", create_window.__doc__)
 
 # Aliases
 gui = create_window
 directory = get_executables_in_folder
 start = start_monitoring
 stop = stop_monitoring
+roots = get_monitored_roots
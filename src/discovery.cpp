@@ -0,0 +1,449 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/discovery.cpp
+DESCRIPTION: Parallel discovery of target executables
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "discovery.h"
+#include "governor.h"
+
+#include <algorithm>
+#include <cctype>
+
+
+bool Target::operator==(const Target& other) const {
+    return (path == other.path) && (name == other.name);
+}
+
+bool glob_match(const char* pattern, const char* text) {
+    /*
+    Match text against a wildcard pattern, ignoring case.
+
+    `*` matches any run of characters and `?` matches exactly one. Matching is
+    iterative, backtracking only to the most recent `*`, so it never recurses.
+    */
+
+    const char* star = nullptr;
+    const char* resume = nullptr;
+
+    while (*text) {
+        if ((*pattern == '?') ||
+            ((*pattern != '*') &&
+             (std::tolower(static_cast<unsigned char>(*pattern)) ==
+              std::tolower(static_cast<unsigned char>(*text))))) {
+            pattern++;
+            text++;
+        }
+        else if (*pattern == '*') {
+            star = pattern++;
+            resume = text;
+        }
+        else if (star) {
+            pattern = star + 1;
+            text = ++resume;
+        }
+        else {
+            return false;
+        }
+    }
+
+    while (*pattern == '*') pattern++;
+
+    return *pattern == '\0';
+}
+
+bool glob_match_any(const std::vector<std::string>& patterns, const char* text) {
+    for (const auto& pattern : patterns) {
+        if (glob_match(pattern.c_str(), text)) return true;
+    }
+
+    return false;
+}
+
+static std::vector<std::string> split_patterns(const std::string& value) {
+    // Patterns are separated by semicolons, e.g. "*.exe;*.com"
+    std::vector<std::string> patterns;
+    std::size_t start = 0;
+
+    while (start <= value.size()) {
+        std::size_t end = value.find(';', start);
+        if (end == std::string::npos) end = value.size();
+
+        std::string pattern = value.substr(start, end - start);
+
+        pattern.erase(0, pattern.find_first_not_of(" \t"));
+        pattern.erase(pattern.find_last_not_of(" \t") + 1);
+
+        if (!pattern.empty()) patterns.push_back(pattern);
+
+        start = end + 1;
+    }
+
+    return patterns;
+}
+
+Discovery::Discovery() {
+    include = split_patterns("*.exe");
+}
+
+Discovery::~Discovery() {
+    // The workers are idle between scans, so they exit straight away
+    stop();
+}
+
+void Discovery::configure(const Settings& settings) {
+    /*
+    Apply the discovery settings.
+
+    * `min_depth` - shallowest level whose files are matched, where the
+      root's entries are 1. The default of 2 skips files directly in the
+      root, as DieKnow always has.
+    * `max_depth` - deepest level walked. A depth of 0 walks the whole tree.
+    * `include` - semicolon-separated patterns a file name must match.
+    * `exclude` - semicolon-separated patterns that skip a file or folder.
+    * `discovery_threads` - worker count, or 0 to pick one automatically.
+    * `discovery_cache` - reuse the last walk of a root while none of its
+      folders changed.
+    * `discovery_watch` - learn that a folder changed from the operating
+      system (see `FolderWatcher`) instead of checking every folder.
+    */
+
+    std::lock_guard<std::mutex> lock(scanning);
+
+    int shallowest = settings.get<int>("min_depth", 2);
+    int depth = settings.get<int>("max_depth", 2);
+    if ((shallowest != min_depth) || (depth != max_depth)) {
+        min_depth = shallowest;
+        max_depth = depth;
+        configuration++;
+    }
+
+    caching = settings.get<bool>("discovery_cache", true);
+
+    bool watch = caching && settings.get<bool>("discovery_watch", true);
+    if (watch != (watcher != nullptr)) {
+        watcher = watch ? create_folder_watcher() : nullptr;
+
+        // Walks watched by the old watcher are checked folder by folder
+        // until walked again
+        for (auto& [root, walk] : walks) walk.watched = false;
+    }
+
+    // Only re-split when the setting actually changed
+    if (settings.copy("include", include_setting, "*.exe")) {
+        include = split_patterns(include_setting);
+        configuration++;
+    }
+    if (settings.copy("exclude", exclude_setting, "")) {
+        exclude = split_patterns(exclude_setting);
+        configuration++;
+    }
+
+    int count = settings.get<int>("discovery_threads", 0);
+    if (count <= 0) {
+        count = static_cast<int>(std::min(4u, std::max(1u, std::thread::hardware_concurrency())));
+    }
+
+    if (static_cast<std::size_t>(count) != threads.size()) {
+        stop();
+        start(static_cast<unsigned>(count));
+    }
+}
+
+void Discovery::start(unsigned count) {
+    for (unsigned i = 0; i < count; i++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+
+    for (unsigned i = 0; i < count; i++) {
+        threads.emplace_back(&Discovery::run, this, i);
+    }
+}
+
+void Discovery::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& thread : threads) thread.join();
+
+    threads.clear();
+    workers.clear();
+    stopping = false;
+}
+
+bool Discovery::take(std::size_t index, Job& job) {
+    /*
+    Take the next folder to walk.
+
+    A worker pops the newest job from the back of its own deque, which keeps
+    the walk depth-first and cache-friendly. When it runs dry it steals the
+    oldest job from the front of another worker's deque, which tends to be a
+    large, shallow subtree.
+    */
+
+    {
+        Worker& own = *workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            queued--;
+            return true;
+        }
+    }
+
+    for (std::size_t i = 1; i < workers.size(); i++) {
+        Worker& victim = *workers[(index + i) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            queued--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Discovery::run(std::size_t index) {
+    Job job;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // Sleep rather than spin while other workers are still busy
+            // reading folders, which matters on slow network shares
+            wake.wait(lock, [this]() { return stopping || (queued > 0); });
+
+            if (stopping) return;
+        }
+
+        while (take(index, job)) {
+            uint64_t start = thread_cpu_time();
+            walk(index, job);
+
+            // Counted before the folder is finished, so a scan that returns
+            // has all of its time counted
+            cpu_time += thread_cpu_time() - start;
+
+            if (pending.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.notify_all();
+            }
+        }
+    }
+}
+
+void Discovery::walk(std::size_t index, const Job& job) {
+    /*
+    Walk a single folder.
+
+    Matching files are recorded and subfolders are queued for any worker to
+    pick up. Unreadable entries are counted and skipped; nothing here ever
+    prompts the user or reloads settings.
+    */
+
+    Worker& worker = *workers[index];
+    std::error_code ec;
+
+    // Watched and timed before reading, so a change made during the walk is
+    // still seen by the next sweep
+    if (watcher && walking) watcher->add(*walking, job.path);
+    worker.folders.push_back({job.path, modified(job.path)});
+
+    std::filesystem::directory_iterator it(
+        job.path,
+        std::filesystem::directory_options::skip_permission_denied,
+        ec
+    );
+
+    if (ec) {
+        errors++;
+        return;
+    }
+
+    for (; it != std::filesystem::directory_iterator(); it.increment(ec)) {
+        if (ec) {
+            errors++;
+            break;
+        }
+
+        const auto& entry = *it;
+        std::string name = entry.path().filename().string();
+
+        // Never follow links, so a junction cannot send the walk in circles
+        if (entry.is_symlink(ec)) continue;
+
+        if (entry.is_directory(ec)) {
+            if ((max_depth > 0) && (job.depth >= max_depth)) continue;
+            if (glob_match_any(exclude, name.c_str())) continue;
+
+            pending++;
+            {
+                std::lock_guard<std::mutex> lock(worker.mutex);
+                worker.jobs.push_back({entry.path(), job.depth + 1});
+                queued++;
+            }
+            {
+                // Taken so an idle worker cannot miss the wakeup
+                std::lock_guard<std::mutex> lock(mutex);
+            }
+            wake.notify_one();
+        }
+        else if ((job.depth >= min_depth) && entry.is_regular_file(ec)) {
+            if (glob_match_any(include, name.c_str()) &&
+                !glob_match_any(exclude, name.c_str())) {
+                worker.found.push_back({entry.path().string(), name});
+            }
+        }
+    }
+}
+
+std::filesystem::file_time_type Discovery::modified(const std::filesystem::path& path) {
+    // A folder that can't be read has no time, so it only counts as
+    // unchanged while it stays unreadable
+    std::error_code ec;
+    auto time = std::filesystem::last_write_time(path, ec);
+    return ec ? std::filesystem::file_time_type::min() : time;
+}
+
+bool Discovery::unchanged(const std::string& root, const Walk& walk) const {
+    /*
+    Check whether no folder of a walk changed since.
+
+    If the watcher watched the whole walk, it already knows without touching
+    the disk. Otherwise every folder must still have the same modification
+    time, which is one stat per folder, with no allocation, instead of
+    reading every entry of every folder again.
+    */
+
+    if (walk.configuration != configuration) return false;
+
+    if (walk.watched && watcher && watcher->watching(root)) return !watcher->changed(root);
+
+    for (const Folder& folder : walk.folders) {
+        if (modified(folder.path) != folder.modified) return false;
+    }
+
+    return !walk.folders.empty();
+}
+
+void Discovery::forget(const std::string& root) {
+    if (watcher) watcher->forget(root);
+    walks.erase(root);
+}
+
+bool Discovery::scan(const std::string& root, std::vector<Target>& targets) {
+    /*
+    Walk `root` in parallel and collect every matching executable.
+
+    Results are sorted by path, so the output is the same no matter which
+    worker found what. Returns false if the root folder cannot be read.
+
+    With `discovery_cache`, a root whose folders are all unchanged since its
+    last walk isn't walked again; its last results are copied into
+    `targets` instead. Once `targets` holds them, that copy reuses its
+    strings, so a sweep over an unchanged tree doesn't allocate. With
+    `discovery_watch` as well, checking that the tree is unchanged doesn't
+    touch the disk either.
+    */
+
+    std::lock_guard<std::mutex> lock(scanning);
+
+    auto cached = walks.find(root);
+    if (caching && (cached != walks.end()) && unchanged(root, cached->second)) {
+        targets = cached->second.targets;
+        reused++;
+        return true;
+    }
+
+    targets.clear();
+
+    std::error_code ec;
+    if (!std::filesystem::is_directory(root, ec)) {
+        if (cached != walks.end()) this->forget(root);
+        errors++;
+        return false;
+    }
+
+    if (threads.empty()) start(1);
+
+    for (auto& worker : workers) {
+        worker->found.clear();
+        worker->folders.clear();
+    }
+
+    if (watcher) watcher->watch(root);
+    walking = &root;
+
+    pending = 1;
+
+    {
+        std::lock_guard<std::mutex> worker_lock(workers[0]->mutex);
+        workers[0]->jobs.push_back({std::filesystem::path(root), 1});
+        queued++;
+    }
+
+    {
+        std::unique_lock<std::mutex> wait_lock(mutex);
+        wake.notify_all();
+        done.wait(wait_lock, [this]() { return pending == 0; });
+    }
+
+    walking = nullptr;
+
+    for (auto& worker : workers) {
+        targets.insert(targets.end(), worker->found.begin(), worker->found.end());
+    }
+
+    std::sort(targets.begin(), targets.end(), [](const Target& a, const Target& b) {
+        return a.path < b.path;
+    });
+
+    if (caching) {
+        // Roots scanned once, e.g. from the GUI, shouldn't pile up
+        if ((cached == walks.end()) && (walks.size() >= DISCOVERY_WALKS)) {
+            if (watcher) {
+                for (const auto& [walked, walk] : walks) watcher->forget(walked);
+            }
+            walks.clear();
+        }
+
+        Walk& walk = walks[root];
+        walk.folders.clear();
+        for (auto& worker : workers) {
+            walk.folders.insert(walk.folders.end(), worker->folders.begin(), worker->folders.end());
+        }
+        walk.targets = targets;
+        walk.configuration = configuration;
+        walk.watched = watcher && watcher->watching(root);
+    }
+
+    return true;
+}
+
+std::size_t Discovery::get_errors() const {
+    return errors;
+}
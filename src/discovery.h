@@ -0,0 +1,148 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/discovery.h
+DESCRIPTION: Parallel discovery of target executables
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef DISCOVERY_H
+#define DISCOVERY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+
+#include "settings.h"
+#include "watcher.h"
+
+// Most roots whose last walk is kept
+#define DISCOVERY_WALKS 16
+
+struct Target {
+    std::string path;
+    std::string name;
+
+    bool operator==(const Target& other) const;
+};
+
+bool glob_match(const char* pattern, const char* text);
+
+bool glob_match_any(const std::vector<std::string>& patterns, const char* text);
+
+class Discovery {
+    struct Job {
+        std::filesystem::path path;
+        // Depth of the entries inside `path`, where the root's entries are 1
+        int depth;
+    };
+
+    // A folder read by a walk, with its modification time from just before
+    // it was read. Adding, removing or renaming an entry changes it.
+    struct Folder {
+        std::filesystem::path path;
+        std::filesystem::file_time_type modified;
+    };
+
+    // The last walk of a root, reused while none of its folders changed
+    struct Walk {
+        std::vector<Folder> folders;
+        std::vector<Target> targets;
+        unsigned configuration = 0;
+        // Whether `watcher` watched every folder of the walk
+        bool watched = false;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+        std::vector<Target> found;
+        std::vector<Folder> folders;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    unsigned generation = 0;
+    bool stopping = false;
+
+    // Folders not yet finished, and folders waiting in a deque
+    std::atomic<std::size_t> pending{0};
+    std::atomic<std::size_t> queued{0};
+    std::atomic<std::size_t> errors{0};
+
+    // CPU time the workers spent walking folders, in microseconds
+    std::atomic<uint64_t> cpu_time{0};
+
+    // Serializes scans from different threads (monitor, GUI, ctypes)
+    std::mutex scanning;
+
+    int min_depth = 2;
+    int max_depth = 2;
+    std::string include_setting;
+    std::string exclude_setting;
+    std::vector<std::string> include;
+    std::vector<std::string> exclude;
+
+    // Bumped whenever a setting that changes what a walk finds changes, which
+    // invalidates every cached walk
+    unsigned configuration = 1;
+    bool caching = true;
+    std::unordered_map<std::string, Walk, StringHash, std::equal_to<>> walks;
+    std::atomic<std::size_t> reused{0};
+
+    // Tells whether a walked tree changed without looking at it, or nullptr
+    // to compare the modification time of every folder instead
+    std::unique_ptr<FolderWatcher> watcher;
+    // Root of the walk in progress, for the workers to add watches under
+    const std::string* walking = nullptr;
+
+    static std::filesystem::file_time_type modified(const std::filesystem::path& path);
+    bool unchanged(const std::string& root, const Walk& walk) const;
+    void forget(const std::string& root);
+
+    void start(unsigned count);
+    void stop();
+    void run(std::size_t index);
+    bool take(std::size_t index, Job& job);
+    void walk(std::size_t index, const Job& job);
+
+public:
+    Discovery();
+    ~Discovery();
+
+    void configure(const Settings& settings);
+
+    bool scan(const std::string& root, std::vector<Target>& targets);
+
+    std::size_t get_errors() const;
+    std::size_t get_reused() const { return reused; }
+    uint64_t get_cpu_time() const { return cpu_time; }
+};
+
+#endif // DISCOVERY_H
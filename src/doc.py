@@ -1,10 +1,25 @@
-"""Documentation parser from C++ code into Python.
+"""Documentation table generator from C++ code.
+
+Run at build time, before compiling the DLLs:
+
+    python src/doc.py
+
+The docstrings of every `DK_API` function are parsed and written into
+`docstrings.h` as a static table, which the DLLs expose through
+`get_docstrings()`. This keeps the parsing out of the Python startup path and
+removes the need to ship the C++ sources alongside the DLLs.
 """
 
+import os
 import re
 
-def doc(file_path, lib):
-    """Parse a C++ file and parse its documentation."""
+
+SOURCES = ["api.cpp", "gui.cpp"]
+OUTPUT = "docstrings.h"
+
+
+def parse(file_path):
+    """Parse a C++ file and return its `(name, docstring)` pairs."""
 
     with open(file_path, "r", encoding="utf-8") as file:
         content = file.read()
@@ -42,7 +57,67 @@ def doc(file_path, lib):
 
             docstrings.append((name, formatted_docstring))
 
+    return docstrings
+
+
+def literal(text):
+    """Escape a string into a C string literal."""
+
+    escaped = []
+
+    for byte in text.encode("utf-8"):
+        character = chr(byte)
+
+        if character == "\\":
+            escaped.append("\\\\")
+        elif character == "\"":
+            escaped.append("\\\"")
+        elif character == "\n":
+            escaped.append("\\n")
+        elif 32 <= byte < 127:
+            escaped.append(character)
+        else:
+            escaped.append(f"\\{byte:03o}")
+
+    return "\"" + "".join(escaped) + "\""
+
+
+def generate(folder):
+    """Write the docstring table for every source in `folder`."""
+
+    docstrings = []
+
+    for source in SOURCES:
+        docstrings.extend(parse(os.path.join(folder, source)))
+
+    lines = [
+        "// Generated by src/doc.py from the DK_API functions in "
+        + ", ".join(SOURCES) + ".",
+        "// Do not edit by hand; rerun `python src/doc.py` instead.",
+        "",
+        "#ifndef DOCSTRINGS_H",
+        "#define DOCSTRINGS_H",
+        "",
+        "static const Docstring DOCSTRINGS[] = {",
+    ]
+
     for (name, docstring) in docstrings:
-        if hasattr(lib, name):
-            func = getattr(lib, name)
-            func.__doc__ = docstring
+        lines.append(f"    {{{literal(name)}, {literal(docstring)}}},")
+
+    lines.extend([
+        "};",
+        "",
+        "#endif // DOCSTRINGS_H",
+        "",
+    ])
+
+    with open(os.path.join(folder, OUTPUT), "w", encoding="utf-8",
+              newline="\n") as file:
+        file.write("\n".join(lines))
+
+    return len(docstrings)
+
+
+if __name__ == "__main__":
+    count = generate(os.path.dirname(os.path.abspath(__file__)))
+    print(f"Generated {count} docstring(s) into {OUTPUT}.")
@@ -0,0 +1,41 @@
+// Generated by src/doc.py from the DK_API functions in api.cpp, gui.cpp.
+// Do not edit by hand; rerun `python src/doc.py` instead.
+
+#ifndef DOCSTRINGS_H
+#define DOCSTRINGS_H
+
+static const Docstring DOCSTRINGS[] = {
+    {"validate", "Check for the validity of the DyKnow installation. If the DyKnow installation cannot be found, the application exits.\n\nSettings are loaded.\n\nSignature: void"},
+    {"get_folder_path", "Retrieve the default DyKnow folder path.\n\nThis is made into a function for use with ctypes.\n\nSignature: const char*"},
+    {"start_monitoring", "Begin monitoring executables.\n\nThe folder is added to the monitored roots (see `add_monitored_root()`), so calling this again while monitoring only adds another root to the running monitor. A null folder starts monitoring the roots already registered.\n\nA separate thread is detached from the primary thread. The thread sets its own priority, affinity and efficiency mode from the `worker_*` settings, below normal priority by default to reduce CPU usage.\n\nMetrics are exported from here on if `metrics_pipe` or `metrics_file` is set, on threads of their own (see `get_metrics()`).\n\nSee `Engine::run()`.\n\nSignature: void"},
+    {"add_monitored_root", "Monitor another folder alongside the others.\n\nEvery root shares the monitor's single sweep and process snapshot, so adding one only costs the walk of its folder. Takes effect on the next sweep. Returns false if the folder is already monitored.\n\nSignature: bool"},
+    {"remove_monitored_root", "Stop monitoring a folder. Its executables are no longer terminated from the next sweep on. Returns false if the folder wasn't monitored.\n\nSignature: bool"},
+    {"get_monitored_roots", "Retrieve a printable list of the monitored folders.\n\nSignature: const char*"},
+    {"stop_monitoring", "Stop monitoring executables.\n\nSignature: void"},
+    {"get_killed_count", "Retrieve the amount of DyKnow executables killed.\n\nIf another DieKnow instance is the one sweeping, its count is read from the shared status segment instead.\n\nSignature: int"},
+    {"is_running", "Check if DieKnow is running or not.\n\nSignature: bool"},
+    {"get_executables_in_folder", "Retrieve a printable list of executables in a folder.\n\nSignature: const char*"},
+    {"register_event_callback", "Register a function to be called for every engine event.\n\nThe callback is invoked on a dedicated dispatcher thread, never on the monitor thread, and receives a pointer to an `Event` that is only valid for the duration of the call. Passing a null callback unregisters it.\n\nSignature: void"},
+    {"unregister_event_callback", "Remove the registered event callback and stop its dispatcher thread.\n\nOnce this returns the callback is no longer running, unless this is called from inside it.\n\nSignature: void"},
+    {"drain_events", "Copy up to `max` pending events into `buffer`, oldest first.\n\nReturns the amount of events copied. Pair this with `get_event_handle()` to wait for events instead of polling.\n\nSignature: int"},
+    {"get_event_handle", "Retrieve a waitable handle that is signalled while events are pending.\n\nThe handle is owned by DieKnow and must not be closed. It is reset once `drain_events()` empties the queue.\n\nSignature: HANDLE"},
+    {"get_dropped_events", "Retrieve the amount of events dropped because the queue was full.\n\nSignature: int"},
+    {"get_docstrings", "Retrieve the table of docstrings for every exported function.\n\nThe table is generated at build time by `doc.py` and lives in the DLL's read-only data, so no source files need to be parsed at startup. The amount of entries is written to `count`.\n\nSignature: const Docstring*"},
+    {"get_handle_cache_stats", "Retrieve how often the process handle cache avoided an `OpenProcess()`.\n\n`hits` and `misses` count handle lookups since the DLL was loaded, and `size` is the amount of handles currently held open.\n\nSignature: void"},
+    {"get_termination_stats", "Retrieve the state of the monitor's kills.\n\n`in_flight` is the amount of kills still waiting for their process to exit, while `retried` and `gave_up` count kills that missed a deadline and kills that ran out of retries since the DLL was loaded.\n\nSignature: void"},
+    {"get_governor_stats", "Retrieve the monitor's own CPU usage and the budget it is held to.\n\n`sweep_ms` is the CPU time of the last sweep and `usage` the percentage of one core the monitor thread and its discovery workers used over the last sweep period. `budget` is the `cpu_budget` setting and `period_ms` the time between sweeps after the governor stretched the interval to fit it.\n\nSignature: void"},
+    {"get_power_state", "Retrieve whether the battery profile is active, and how many times the machine switched between battery and AC power since monitoring started.\n\nSignature: void"},
+    {"get_shared_status", "Copy the counters published by whichever DieKnow instance is sweeping.\n\nThe copy is read straight from shared memory without locks or IPC, so it is cheap enough to poll. `owner` is the PID of that instance. Returns false if no instance has published yet.\n\nSignature: bool"},
+    {"get_metrics", "Render every engine metric in the Prometheus text exposition format.\n\nThis is the same text served on `metrics_pipe` and written to `metrics_file`: counters, gauges, and histograms of kill latency and sweep duration. The buffer is reused, so the text is only valid until the next call.\n\nSignature: const char*"},
+    {"get_target_count", "Retrieve how many targets have been given an ID.\n\nIDs run from 0 up to this count and are never reused, so they can index arrays on the Python side too. Events carry the ID of their target.\n\nSignature: int"},
+    {"get_target_name", "Retrieve the name of a target by its ID, as it was first discovered, or null if no target has that ID.\n\nSignature: const char*"},
+    {"get_target_stats", "Retrieve how many processes of a target were matched, terminated and given up on since the DLL was loaded. Returns false if no target has that ID.\n\nSignature: bool"},
+    {"get_respawns_prevented", "Retrieve how many targets were terminated after their targeted parent instead of before it.\n\nEach one is a relaunch by a supervisor that killing in snapshot order would have allowed. Only counted while `tree_order` is enabled.\n\nSignature: int"},
+    {"get_process_backend", "Retrieve the name of the process enumeration backend in use.\n\nThe backend is selected with the `process_backend` setting.\n\nSignature: const char*"},
+    {"dialog", "Show a message box with the given message, title and `MB_` flags.\n\nReturns the button that was pressed, as `MessageBoxW()` does.\n\nSignature: int __stdcall"},
+    {"bsod", "Open the Windows Blue Screen of Death via win32api's `NtRaiseHardError`.\n\nUse with caution! Your system will freeze and shut down within a few seconds, losing any unsaved work.\n\nSignature: int __stdcall"},
+    {"create_window", "Open the DieKnow GUI and block until it is closed.\n\nSignature: void"},
+    {"profile_window", "Open the GUI, let it refresh `refreshes` times at the period of the `update` setting, then close it. Returns the average time of a refresh in milliseconds.\n\nThis drives `Application::update()` without anybody clicking, to train and measure the optimized build (see tests/profile.py).\n\nSignature: double"},
+};
+
+#endif // DOCSTRINGS_H
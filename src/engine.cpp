@@ -0,0 +1,495 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/engine.cpp
+DESCRIPTION: Portable monitoring engine
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "engine.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+
+Engine::Engine(const EngineModules& modules, Clock& clock, const std::string& identity_file)
+    : modules(modules), clock(clock), identity_file(identity_file), self(current_process_id()),
+      lease(lease_token(self)),
+      wanted(TARGET_CHUNK, 0), discovered(TARGET_CHUNK, 0) {}
+
+void Engine::publish(int type, uint32_t pid, const char* name, uint32_t value, uint32_t count,
+                     uint32_t target) {
+    /*
+    Publish an engine event to subscribers and append it to the journal.
+
+    `value` and `count` only go to the journal; see `JournalRecord`. The
+    target ID only goes to subscribers.
+    */
+
+    modules.events->push(type, pid, name, target);
+    modules.journal->append(type, pid, name, value, count);
+}
+
+bool Engine::report(const Kill& kill) {
+    /*
+    Log the outcome of a finished kill and publish its event.
+
+    Returns whether the process was confirmed terminated.
+    */
+
+    if (kill.state == Kills::CONFIRMED) {
+        std::cout << "Process " << kill.name << " terminated successfully.\n";
+        auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(
+            clock.now() - kill.requested).count();
+
+        publish(Events::TERMINATED, kill.pid, kill.name,
+                static_cast<uint32_t>(latency), static_cast<uint32_t>(kill.attempts), kill.target);
+        return true;
+    }
+
+    std::cerr << "Gave up terminating " << kill.name << " after "
+              << kill.attempts << " attempt(s)!\n";
+    publish(Events::FAILED, kill.pid, kill.name, 0, static_cast<uint32_t>(kill.attempts), kill.target);
+    return false;
+}
+
+bool Engine::snapshot(std::vector<ProcessInfo>& processes) {
+    /*
+    Fill `processes` with every running process.
+
+    The backend is chosen by the `process_backend` setting ("ntquery" or
+    "toolhelp" on Windows, "procfs" elsewhere) and can be switched at
+    runtime, unless the modules bring a source of their own. It is shared
+    by the monitor thread and the GUI, so access is serialized.
+    */
+
+    std::lock_guard<std::mutex> lock(source_mutex);
+
+    if (!modules.processes &&
+        (modules.settings->copy("process_backend", backend, "ntquery") || !source)) {
+        source = create_process_source(backend);
+    }
+
+    return current_source()->snapshot(processes);
+}
+
+ProcessSource* Engine::current_source() const {
+    // Caller must hold `source_mutex`
+    return modules.processes ? modules.processes : source.get();
+}
+
+const char* Engine::get_backend() const {
+    std::lock_guard<std::mutex> lock(source_mutex);
+    ProcessSource* current = current_source();
+    return current ? current->name() : "none";
+}
+
+int Engine::match(const std::vector<ProcessInfo>& processes, bool by_hash) {
+    /*
+    Close every process in a snapshot that is a target.
+
+    A process matches if its name has the ID of a current target or, with
+    `by_hash`, if its image has the same contents as a target even though it
+    has been renamed. Both are looked up once per process and remembered
+    until it exits (or the targets change), so a steady sweep neither looks
+    up names nor reads images, and the identity cache only reads files whose
+    size matches a target. Where the backend gives no creation time, a PID
+    is also looked up again when its name changes.
+
+    With the `tree_order` setting, matches are terminated from the roots of
+    the process tree downward, so a supervisor is gone before the children it
+    would relaunch are killed.
+
+    Matches are only requested from the terminator; the kills themselves
+    are advanced by `advance()`. Processes already being terminated are
+    skipped. Returns the amount of kills requested.
+    */
+
+    TargetRegistry& registry = *modules.registry;
+
+    sweeps++;
+    matches.clear();
+    process_targets.resize(processes.size());
+    int requested = 0;
+
+    // Close the handles of any cached processes that have since exited
+    modules.handles->prune();
+
+    for (std::size_t i = 0; i < processes.size(); i++) {
+        const ProcessInfo& process = processes[i];
+        uint32_t pid = process.pid;
+        if ((pid == 0) || (pid == self)) continue;
+        if (modules.terminator->tracking(pid)) continue;
+
+        // Without a creation time, only the name can tell a reused PID apart
+        std::size_t name = 0;
+        if (process.create_time == 0) name = std::hash<std::string_view>{}(process.name);
+
+        auto it = verdicts.find(pid);
+        if ((it == verdicts.end()) || (it->second.create_time != process.create_time) ||
+            (it->second.name != name)) {
+            Verdict verdict = {process.create_time, name, registry.find(process.name), false, false, sweeps};
+            it = verdicts.insert_or_assign(pid, verdict).first;
+        }
+
+        Verdict& verdict = it->second;
+        verdict.sweep = sweeps;
+
+        process_targets[i] = verdict.target;
+        // The GUI interns names too, so an ID can be past the end of `wanted`
+        bool match = (verdict.target < wanted.size()) && wanted[verdict.target];
+
+        if (!match && by_hash) {
+            if (!verdict.hashed) {
+                char image[PROCESS_PATH_LENGTH];
+                bool found;
+                {
+                    std::lock_guard<std::mutex> lock(source_mutex);
+                    ProcessSource* current = current_source();
+                    found = current && current->image(pid, image, sizeof(image));
+                }
+
+                verdict.renamed = found && modules.identities->matches(image);
+                verdict.hashed = true;
+            }
+
+            match = verdict.renamed;
+        }
+
+        if (match) matches.push_back(i);
+    }
+
+    if (modules.settings->get<bool>("tree_order", true)) {
+        respawns_prevented += static_cast<int>(tree.order(processes, matches));
+    }
+
+    for (std::size_t i : matches) {
+        const ProcessInfo& process = processes[i];
+        uint32_t target = process_targets[i];
+
+        if (target != TARGET_NONE) registry.get(target).matched++;
+
+        publish(Events::PROCESS_MATCHED, process.pid, process.name, 0, 0, target);
+
+        if (modules.terminator->request(process.pid, process.create_time, process.name, target)) {
+            requested++;
+        }
+    }
+
+    // Forget processes that have exited, so a reused PID is looked up again
+    for (auto it = verdicts.begin(); it != verdicts.end();) {
+        if (it->second.sweep != sweeps) it = verdicts.erase(it);
+        else ++it;
+    }
+
+    return requested;
+}
+
+void Engine::update_power() {
+    /*
+    Read the power source, and log and publish a switch between the battery
+    and AC profiles. Only called by the monitor thread.
+    */
+
+    if (!modules.power->update()) return;
+
+    const char* name = modules.power->on_battery() ? "battery" : "ac";
+
+    std::cout << "Switched to the " << name << " profile.\n";
+    publish(Events::POWER_CHANGED, 0, name);
+}
+
+void Engine::publish_status() {
+    // Only called by the monitor thread while it holds the lease
+    SharedStats stats = {};
+
+    stats.owner = self;
+    stats.running = active ? 1 : 0;
+    stats.roots = static_cast<int32_t>(modules.roots->size());
+    stats.on_battery = modules.power->on_battery() ? 1 : 0;
+    stats.killed = killed;
+    stats.in_flight = static_cast<int64_t>(modules.terminator->in_flight());
+    stats.retried = static_cast<int64_t>(modules.terminator->get_retried());
+    stats.gave_up = static_cast<int64_t>(modules.terminator->get_gave_up());
+    stats.respawns_prevented = respawns_prevented;
+    stats.sweep_ms = modules.governor->get_sweep_cost();
+    stats.usage = modules.governor->get_usage();
+    stats.budget = modules.governor->get_budget();
+    stats.period_ms = modules.governor->get_period();
+    stats.updated = clock.wall();
+
+    modules.shared->publish(stats);
+}
+
+void Engine::advance() {
+    // Only the monitor thread touches the terminator, and it is the only
+    // producer of `activity`
+    finished.clear();
+    modules.terminator->advance(finished);
+
+    if (finished.empty()) return;
+
+    auto now = clock.now();
+    int64_t timestamp = clock.wall();
+
+    for (const Kill& kill : finished) {
+        bool confirmed = report(kill);
+        if (confirmed) killed++;
+
+        double latency = std::chrono::duration<double>(now - kill.requested).count();
+        if (confirmed) modules.kill_latency->observe(latency);
+
+        if (kill.target != TARGET_NONE) {
+            TargetEntry& entry = modules.registry->get(kill.target);
+
+            if (confirmed) {
+                entry.killed++;
+                entry.kill_latency.observe(latency);
+            }
+            else {
+                entry.gave_up++;
+            }
+        }
+
+        Activity entry;
+        entry.pid = kill.pid;
+        entry.result = kill.state;
+        entry.timestamp = timestamp;
+        entry.latency = static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - kill.requested).count());
+        entry.attempts = static_cast<uint32_t>(kill.attempts);
+        entry.target = kill.target;
+        std::strncpy(entry.name, kill.name, ACTIVITY_NAME_LENGTH - 1);
+        entry.name[ACTIVITY_NAME_LENGTH - 1] = '\0';
+
+        modules.activity->push(entry);
+    }
+}
+
+int Engine::sweep() {
+    /*
+    Sweep every registered root once: discover the targets, match them
+    against one process snapshot and request their kills.
+
+    A folder that can't be read is skipped until the next sweep, and a
+    `TARGET_DISCOVERED` event is published the first time each target is
+    seen. Once warmed up, a sweep over unchanged folders and processes makes
+    no heap allocations; tests/testsweep.cpp checks this.
+
+    Returns how long to wait before the next sweep in milliseconds, after
+    the governor.
+    */
+
+    Settings& settings = *modules.settings;
+
+    auto now = clock.now();
+
+    update_power();
+
+    // Only touch the scheduler when the worker settings change
+    policy.configure(settings);
+    policy.efficient = modules.power->get<bool>(settings, "worker_efficiency", policy.efficient);
+    if (!policy_applied || !(policy == applied)) {
+        policy.apply();
+        applied = policy;
+        policy_applied = true;
+    }
+
+    modules.governor->configure(settings);
+    modules.governor->begin(modules.discovery->get_cpu_time());
+
+    modules.discovery->configure(settings);
+
+    modules.roots->copy(folders, folders_version);
+
+    // Search recursively through every root and terminate all targets.
+    // The results are assigned over the last sweep's, so while nothing
+    // changes their strings are reused rather than allocated again.
+    std::size_t count = 0;
+    for (const auto& folder : folders) {
+        if (!modules.discovery->scan(folder, found)) {
+            std::cerr << "Unable to read the folder " << folder << "!\n";
+            continue;
+        }
+
+        for (const auto& target : found) {
+            if (count < targets.size()) targets[count] = target;
+            else targets.push_back(target);
+            count++;
+        }
+    }
+    targets.erase(targets.begin() + static_cast<std::ptrdiff_t>(count), targets.end());
+
+    // Nested roots find the same files twice
+    if (folders.size() > 1) {
+        std::sort(targets.begin(), targets.end(), [](const Target& a, const Target& b) {
+            return a.path < b.path;
+        });
+        targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+    }
+
+    // Targets are matched by ID, so only a change to them touches names
+    if (targets != known) {
+        known = targets;
+
+        std::fill(wanted.begin(), wanted.end(), 0);
+        for (const auto& target : targets) {
+            uint32_t id = modules.registry->intern(target.name);
+
+            if (id == TARGET_NONE) {
+                std::cerr << "Too many targets to match " << target.name << " by name!\n";
+                continue;
+            }
+
+            // Grown a chunk at a time, like the registry, and only when the
+            // targets change
+            if (id >= wanted.size()) {
+                std::size_t size = (id / TARGET_CHUNK + 1) * TARGET_CHUNK;
+                wanted.resize(size, 0);
+                discovered.resize(size, 0);
+            }
+
+            wanted[id] = 1;
+
+            if (!discovered[id]) {
+                discovered[id] = 1;
+                publish(Events::TARGET_DISCOVERED, 0, target.name.c_str(), 0, 0, id);
+            }
+        }
+
+        // Names no target had before may be targets now
+        verdicts.clear();
+    }
+
+    modules.handles->resize(settings.get<int>("handle_cache_size", 32));
+
+    bool by_hash = settings.get<bool>("match_by_hash", true);
+    if (by_hash) modules.identities->refresh(targets);
+
+    int requested = 0;
+
+    if (snapshot(processes)) {
+        requested = match(processes, by_hash);
+
+        // Signal the new kills straight away, in tree order
+        advance();
+    }
+
+    if (by_hash) modules.identities->save(identity_file);
+
+    // The power source may have changed the interval
+    int interval = modules.power->get<int>(settings, "interval", 0);
+
+    auto elapsed = clock.now() - now;
+    modules.sweep_duration->observe(std::chrono::duration<double>(elapsed).count());
+
+    if (settings.get<bool>("journal_sweeps", true)) {
+        modules.journal->append(
+            Records::SWEEP, 0, nullptr,
+            static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()),
+            static_cast<uint32_t>(requested)
+        );
+    }
+
+    // Stretched by the governor if sweeps cost more than the CPU budget
+    return modules.governor->end(interval * 1000, modules.discovery->get_cpu_time());
+}
+
+bool Engine::run(const std::atomic<bool>& running) {
+    /*
+    Sweep every registered root until `running` is cleared.
+
+    Kills in flight are advanced every tick. Between sweeps the loop waits
+    for the interval (as stretched by the governor), waking early at each
+    kill deadline so retries and give-ups happen on time. Only the instance
+    holding the shared lease sweeps, and it publishes its status after every
+    tick.
+
+    The engine is not safe for two threads, so this returns false straight
+    away if it is already running on another.
+    */
+
+    Settings& settings = *modules.settings;
+    SharedSegment* shared = modules.shared;
+    Terminator& terminator = *modules.terminator;
+
+    if (active.exchange(true)) {
+        std::cerr << "The engine is already running on another thread!\n";
+        return false;
+    }
+
+    modules.identities->load(identity_file);
+
+    if (settings.get<bool>("journal", true)) {
+        std::string path = settings.get<std::string>("journal_path", "./journal.dkj");
+
+        if (!modules.journal->open(path, settings.get<int>("journal_records", 65536),
+                                   settings.get<int>("journal_files", 4))) {
+            std::cerr << "Unable to open the journal " << path << "!\n";
+        }
+    }
+
+    auto owner = [&]() { return shared && (shared->get_holder() == lease); };
+
+    auto next_sweep = clock.now();
+
+    while (running) {
+        terminator.configure(settings);
+        advance();
+
+        // The GUI only flags a power change; reading it is left to this thread
+        if (modules.power->recheck_requested()) update_power();
+
+        if (owner()) publish_status();
+
+        auto now = clock.now();
+        if (now < next_sweep) {
+            auto remaining = std::chrono::ceil<std::chrono::milliseconds>(next_sweep - now);
+
+            // Minimize CPU usage, waking early for the next kill deadline
+            if (terminator.in_flight() > 0) terminator.wait(static_cast<int>(remaining.count()));
+            else clock.sleep(remaining);
+
+            continue;
+        }
+
+        int interval = modules.power->get<int>(settings, "interval", 0);
+
+        // Only one instance per session sweeps. The lease outlives a few
+        // sweep periods, so a busy owner never loses it between renewals.
+        int duration = (std::max(interval * 1000, modules.governor->get_period()) * 3) + 5000;
+
+        if (shared && settings.get<bool>("single_instance", true) && !shared->acquire_lease(lease, duration)) {
+            next_sweep = now + std::chrono::milliseconds(std::max(interval * 1000, 1000));
+            continue;
+        }
+
+        int period = sweep();
+        next_sweep = clock.now() + std::chrono::milliseconds(period);
+
+        if (owner()) publish_status();
+    }
+
+    if (owner()) {
+        publish_status();
+        shared->release_lease(lease);
+    }
+
+    active = false;
+    return true;
+}
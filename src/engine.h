@@ -0,0 +1,173 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/engine.h
+DESCRIPTION: Portable monitoring engine
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+#include "settings.h"
+#include "events.h"
+#include "discovery.h"
+#include "identity.h"
+#include "process.h"
+#include "handles.h"
+#include "termination.h"
+#include "roots.h"
+#include "governor.h"
+#include "scheduling.h"
+#include "power.h"
+#include "activity.h"
+#include "shared.h"
+#include "metrics.h"
+#include "journal.h"
+#include "clock.h"
+#include "registry.h"
+
+// Where the content hashes of executables persist between runs
+#define IDENTITY_CACHE "./identity.cache"
+
+// The modules the engine works with. They belong to whoever runs the engine
+// (the DLL's globals, or a test's own) and must outlive it.
+struct EngineModules {
+    Settings* settings;
+    EventQueue* events;
+    Discovery* discovery;
+    IdentityCache* identities;
+    HandleCache* handles;
+    Terminator* terminator;
+    RootRegistry* roots;
+    Governor* governor;
+    PowerMonitor* power;
+    ActivityRing* activity;
+    // Without a segment there is no lease, and the engine always sweeps
+    SharedSegment* shared;
+    Journal* journal;
+    Histogram* kill_latency;
+    Histogram* sweep_duration;
+    TargetRegistry* registry;
+    // Without a source, the `process_backend` setting picks one
+    ProcessSource* processes;
+};
+
+// The monitor itself: discovering targets, matching them against the running
+// processes and seeing their kills through. Everything it needs from the
+// operating system goes through `ProcessSource`, `FolderWatcher` (inside
+// `Discovery`), `Terminator` and `Clock`, so it builds and runs anywhere.
+class Engine {
+    EngineModules modules;
+    Clock& clock;
+    std::string identity_file;
+    uint32_t self;
+    // Identifies this engine to the shared lease, apart from any other engine
+    // in the same process
+    uint64_t lease;
+
+    // Chosen by the `process_backend` setting unless the modules bring a
+    // source, and shared with other threads through `snapshot()`
+    std::unique_ptr<ProcessSource> source;
+    std::string backend;
+    mutable std::mutex source_mutex;
+
+    ProcessSource* current_source() const;
+
+    std::atomic<bool> active{false};
+    std::atomic<int> killed{0};
+    // Targets killed before a targeted ancestor that would otherwise have
+    // relaunched them, had they been killed in snapshot order
+    std::atomic<int> respawns_prevented{0};
+
+    // Kept across sweeps, so a sweep over unchanged folders and processes
+    // doesn't allocate
+    std::vector<Target> targets;
+    // Targets `wanted` was last built from
+    std::vector<Target> known;
+    // Indexed by target ID: whether it is one of the current targets, and
+    // whether its `TARGET_DISCOVERED` event was published. They grow with
+    // the registry.
+    std::vector<uint8_t> wanted;
+    std::vector<uint8_t> discovered;
+    std::vector<Target> found;
+    std::vector<std::string> folders;
+    uint64_t folders_version = 0;
+    std::vector<ProcessInfo> processes;
+    std::vector<Kill> finished;
+
+    // What a process was found to be, looked up once per process
+    struct Verdict {
+        // Tells a reused PID apart from the process the verdict is about
+        uint64_t create_time;
+        // Hash of the process's name, which tells a reused PID apart where
+        // the backend has no creation time (Toolhelp32). Only set then.
+        std::size_t name;
+        // ID of its name, or `TARGET_NONE` if no target ever had that name
+        uint32_t target;
+        // Whether its image was hashed, and had the contents of a target
+        bool hashed;
+        bool renamed;
+        // Sweep it was last seen in
+        unsigned sweep;
+    };
+
+    std::unordered_map<uint32_t, Verdict> verdicts;
+    unsigned sweeps = 0;
+    std::vector<std::size_t> matches;
+    // Target ID of each process in the snapshot being matched
+    std::vector<uint32_t> process_targets;
+    ProcessTree tree;
+
+    WorkerPolicy policy;
+    WorkerPolicy applied;
+    bool policy_applied = false;
+
+public:
+    Engine(const EngineModules& modules, Clock& clock, const std::string& identity_file = IDENTITY_CACHE);
+
+    bool run(const std::atomic<bool>& running);
+    int sweep();
+
+    void advance();
+    int match(const std::vector<ProcessInfo>& processes, bool by_hash);
+    bool snapshot(std::vector<ProcessInfo>& processes);
+
+    void publish(int type, uint32_t pid, const char* name, uint32_t value = 0, uint32_t count = 0,
+                 uint32_t target = TARGET_NONE);
+    bool report(const Kill& kill);
+    void update_power();
+    void publish_status();
+
+    void count_kill() { killed++; }
+
+    int get_killed() const { return killed; }
+    uint64_t get_lease() const { return lease; }
+    int get_respawns_prevented() const { return respawns_prevented; }
+    const char* get_backend() const;
+    const std::vector<Target>& get_targets() const { return targets; }
+};
+
+#endif // ENGINE_H
@@ -0,0 +1,261 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/events.cpp
+DESCRIPTION: Event stream published by the DieKnow engine
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "events.h"
+
+#include <chrono>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+
+EventQueue::EventQueue(std::size_t capacity) : buffer(capacity) {
+    /*
+    Create an event queue with a fixed capacity.
+
+    The storage is allocated once here so pushing from the monitor thread
+    never allocates. A manual-reset event (or an eventfd outside of Windows)
+    is signalled whenever the queue holds undrained events.
+    */
+
+#ifdef _WIN32
+    handle = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+#else
+    handle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+}
+
+EventQueue::~EventQueue() {
+    // Joining during DLL unload can deadlock on the loader lock, and the
+    // dispatcher is torn down with the process anyway.
+    if (dispatcher.joinable()) dispatcher.detach();
+
+#ifdef _WIN32
+    if (handle) CloseHandle(handle);
+#else
+    if (handle >= 0) close(handle);
+#endif
+}
+
+void EventQueue::signal() {
+#ifdef _WIN32
+    SetEvent(handle);
+#else
+    uint64_t one = 1;
+    ssize_t written = write(handle, &one, sizeof(one));
+    (void)written;
+#endif
+}
+
+void EventQueue::reset() {
+#ifdef _WIN32
+    ResetEvent(handle);
+#else
+    uint64_t value;
+    ssize_t read_bytes = read(handle, &value, sizeof(value));
+    (void)read_bytes;
+#endif
+}
+
+void EventQueue::push(int type, uint32_t pid, const char* name, uint32_t target) {
+    /*
+    Publish an event.
+
+    If the queue is full the oldest event is overwritten and counted as
+    dropped, so a slow host can never stall the monitor thread.
+    */
+
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        std::size_t index = (head + count) % buffer.size();
+
+        if (count == buffer.size()) {
+            head = (head + 1) % buffer.size();
+            dropped++;
+        }
+        else {
+            count++;
+        }
+
+        Event& event = buffer[index];
+        event.type = type;
+        event.pid = pid;
+        event.target = target;
+        event.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+
+        if (name) {
+            std::strncpy(event.name, name, EVENT_NAME_LENGTH - 1);
+            event.name[EVENT_NAME_LENGTH - 1] = '\0';
+        }
+        else {
+            event.name[0] = '\0';
+        }
+    }
+
+    signal();
+    condition.notify_one();
+}
+
+std::size_t EventQueue::pop(Event* out, std::size_t max) {
+    // Caller must hold `mutex`
+    std::size_t amount = (count < max) ? count : max;
+
+    for (std::size_t i = 0; i < amount; i++) {
+        out[i] = buffer[head];
+        head = (head + 1) % buffer.size();
+    }
+    count -= amount;
+
+    if (count == 0) reset();
+
+    return amount;
+}
+
+int EventQueue::drain(Event* out, int max) {
+    /*
+    Copy up to `max` pending events into `out`, oldest first.
+
+    Returns the amount of events copied. The wait handle is reset once the
+    queue is empty.
+    */
+
+    if (!out || max <= 0) return 0;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<int>(pop(out, static_cast<std::size_t>(max)));
+}
+
+void EventQueue::dispatch() {
+    /*
+    Deliver events to the registered callback.
+
+    This runs on its own thread so a slow callback (such as one calling back
+    into Python) never delays the monitor thread. Events are copied out in
+    batches and the lock is released while the callback runs.
+    */
+
+    Event batch[64];
+
+    while (true) {
+        std::size_t amount;
+        EventCallback function;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return (count > 0) || !callback; });
+
+            if (!callback) {
+                dispatching = false;
+                idle.notify_all();
+                return;
+            }
+
+            function = callback;
+            amount = pop(batch, sizeof(batch) / sizeof(batch[0]));
+            delivering = true;
+        }
+
+        for (std::size_t i = 0; i < amount; i++) {
+            function(&batch[i]);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            delivering = false;
+        }
+        idle.notify_all();
+    }
+}
+
+void EventQueue::subscribe(EventCallback function) {
+    /*
+    Register a callback to be invoked for every event.
+
+    Only one callback may be registered at a time; registering another
+    replaces it, and returns once the dispatcher has left the old one
+    (unless the old one is the caller). While a callback is registered it
+    consumes the queue, so `drain()` will only see events the dispatcher has
+    not picked up yet.
+
+    There is only ever one dispatcher, so callbacks never run concurrently
+    or out of order. A dispatcher that is still running, such as one whose
+    callback unsubscribed itself, carries on with the new callback.
+    */
+
+    if (!function) {
+        unsubscribe();
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    bool inside = dispatching && (std::this_thread::get_id() == delivery);
+    if (!inside) idle.wait(lock, [this]() { return !delivering; });
+
+    callback = function;
+
+    if (!dispatching) {
+        // The last dispatcher has returned, so this never blocks
+        if (dispatcher.joinable()) dispatcher.join();
+
+        dispatching = true;
+        dispatcher = std::thread(&EventQueue::dispatch, this);
+        delivery = dispatcher.get_id();
+    }
+}
+
+void EventQueue::unsubscribe() {
+    /*
+    Remove the registered callback and stop the dispatcher thread.
+
+    Once this returns the callback is no longer running, unless it is the
+    caller, in which case the dispatcher exits after it returns.
+    */
+
+    std::unique_lock<std::mutex> lock(mutex);
+    callback = nullptr;
+    condition.notify_all();
+
+    // A callback may unsubscribe itself, in which case it cannot wait for
+    // itself
+    if (dispatching && (std::this_thread::get_id() == delivery)) return;
+
+    idle.wait(lock, [this]() { return !dispatching; });
+    lock.unlock();
+
+    if (dispatcher.joinable()) dispatcher.join();
+}
+
+EventHandle EventQueue::get_handle() const {
+    return handle;
+}
+
+std::size_t EventQueue::get_dropped() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return dropped;
+}
@@ -0,0 +1,120 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/events.h
+DESCRIPTION: Event stream published by the DieKnow engine
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Length of the name carried by an event, including the null terminator
+#define EVENT_NAME_LENGTH 260
+
+// Amount of events held before the oldest ones are dropped
+#define EVENT_CAPACITY 1024
+
+
+namespace Events {
+    enum Type {
+        TARGET_DISCOVERED = 0,
+        PROCESS_MATCHED,
+        TERMINATED,
+        FAILED,
+        SETTINGS_RELOADED,
+        // The name is "battery" or "ac"
+        POWER_CHANGED,
+    };
+}
+
+extern "C"
+{
+    // Plain layout so it can be mirrored with a ctypes Structure
+    struct Event {
+        int32_t type;
+        uint32_t pid;
+        // Milliseconds since the Unix epoch
+        int64_t timestamp;
+        char name[EVENT_NAME_LENGTH];
+        // ID of the target the event is about (see `get_target_name()`), or
+        // UINT32_MAX for none
+        uint32_t target;
+    };
+
+    typedef void (*EventCallback)(const Event* event);
+}
+
+#ifdef _WIN32
+typedef HANDLE EventHandle;
+#else
+typedef int EventHandle;
+#endif
+
+class EventQueue {
+    std::vector<Event> buffer;
+    std::size_t head = 0;
+    std::size_t count = 0;
+    std::size_t dropped = 0;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+
+    EventCallback callback = nullptr;
+    std::thread dispatcher;
+    // ID of the dispatcher thread, kept while it runs
+    std::thread::id delivery;
+    // Whether the dispatcher is inside a callback, and whether its thread
+    // is still running (even detached), with `idle` notified when either
+    // clears
+    bool delivering = false;
+    bool dispatching = false;
+    std::condition_variable idle;
+
+    EventHandle handle;
+
+    void signal();
+    void reset();
+    void dispatch();
+    std::size_t pop(Event* out, std::size_t max);
+
+public:
+    explicit EventQueue(std::size_t capacity = EVENT_CAPACITY);
+    ~EventQueue();
+
+    void push(int type, uint32_t pid, const char* name, uint32_t target = UINT32_MAX);
+    int drain(Event* out, int max);
+
+    void subscribe(EventCallback function);
+    void unsubscribe();
+
+    EventHandle get_handle() const;
+    std::size_t get_dropped();
+};
+
+#endif // EVENTS_H
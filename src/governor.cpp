@@ -0,0 +1,121 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/governor.cpp
+DESCRIPTION: CPU budget for the monitor thread
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "governor.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <ctime>
+#endif
+
+
+uint64_t thread_cpu_time() {
+    /*
+    Retrieve the CPU time used by the calling thread, in microseconds.
+    */
+
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) return 0;
+
+    // FILETIMEs count 100 ns intervals
+    uint64_t total = ((static_cast<uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime) +
+                     ((static_cast<uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime);
+    return total / 10;
+#else
+    timespec time = {};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return static_cast<uint64_t>(time.tv_sec) * 1000000 + static_cast<uint64_t>(time.tv_nsec) / 1000;
+#endif
+}
+
+void Governor::configure(const Settings& settings) {
+    /*
+    Read `cpu_budget`, the share of one core in percent the monitor thread and
+    its discovery workers may use together. 0 disables the governor.
+    */
+
+    budget = std::max(0.0, settings.get<double>("cpu_budget", 2.0));
+}
+
+void Governor::begin(uint64_t workers) {
+    /*
+    Mark the start of a sweep.
+
+    `workers` is the CPU time the discovery workers have used so far, in
+    microseconds, since the folders are walked on their threads rather than
+    the caller's. Added to the calling thread's own, the CPU time since the
+    previous sweep started, over the wall time since, is the measured usage,
+    which includes the kill ticks between sweeps.
+    */
+
+    uint64_t now_cpu = thread_cpu_time() + workers;
+    auto now_wall = std::chrono::steady_clock::now();
+
+    if (measured) {
+        double wall = std::chrono::duration<double, std::micro>(now_wall - cycle_wall).count();
+        if (wall > 0) usage = 100.0 * static_cast<double>(now_cpu - cycle_cpu) / wall;
+    }
+
+    cycle_cpu = now_cpu;
+    cycle_wall = now_wall;
+    measured = true;
+
+    sweep_start = now_cpu;
+}
+
+int Governor::end(int interval, uint64_t workers) {
+    /*
+    Mark the end of a sweep and retrieve how many milliseconds to wait until
+    the next one.
+
+    That is the configured `interval` (in milliseconds) unless the sweeps
+    cost too much CPU for it: the wait is then stretched so the average sweep
+    cost over the whole period stays within the budget. An average is used
+    so a single slow sweep (e.g. hashing a new target) doesn't stall the
+    cadence, and the cadence returns to the interval once sweeps get cheap
+    again. `workers` is as for `begin`.
+    */
+
+    double cost = static_cast<double>(thread_cpu_time() + workers - sweep_start) / 1000.0;
+    sweep_cost = cost;
+
+    // Exponential moving average over roughly the last eight sweeps
+    double average = average_cost;
+    average = (average == 0.0) ? cost : (average * 0.875) + (cost * 0.125);
+    average_cost = average;
+
+    int wait = interval;
+    double budget = this->budget;
+
+    if (budget > 0) {
+        double needed = average * 100.0 / budget;
+        wait = std::max(wait, static_cast<int>(std::ceil(std::min(needed, static_cast<double>(GOVERNOR_MAX_PERIOD)))));
+    }
+
+    period = wait;
+    return wait;
+}
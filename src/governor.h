@@ -0,0 +1,67 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/governor.h
+DESCRIPTION: CPU budget for the monitor thread
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+
+#include "settings.h"
+
+// Longest the governor stretches the time between sweeps, in milliseconds, so
+// a slow sweep never stops monitoring altogether
+#define GOVERNOR_MAX_PERIOD 60000
+
+
+uint64_t thread_cpu_time();
+
+class Governor {
+    // Written by the monitor thread in `configure`, read from any
+    std::atomic<double> budget{2.0};
+
+    // CPU times are those of the monitor thread plus the discovery workers
+    uint64_t sweep_start = 0;
+    uint64_t cycle_cpu = 0;
+    std::chrono::steady_clock::time_point cycle_wall;
+    bool measured = false;
+
+    // Read from other threads for statistics
+    std::atomic<double> sweep_cost{0.0};
+    std::atomic<double> average_cost{0.0};
+    std::atomic<double> usage{0.0};
+    std::atomic<int> period{0};
+
+public:
+    void configure(const Settings& settings);
+
+    void begin(uint64_t workers);
+    int end(int interval, uint64_t workers);
+
+    double get_sweep_cost() const { return sweep_cost; }
+    double get_usage() const { return usage; }
+    double get_budget() const { return budget; }
+    int get_period() const { return period; }
+};
+
+#endif // GOVERNOR_H
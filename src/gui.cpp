@@ -22,6 +22,13 @@ VERSION: 1.0.1
 
 #include "gui.h"
 
+// Wall time of every timer refresh of the window
+Histogram update_duration;
+
+// Timer refreshes after which the window closes itself, or 0 to stay open.
+// Only set by `profile_window()`.
+static int refresh_limit = 0;
+
 
 void tooltip(HWND hwnd, HWND control, const char* text) {
     /*
@@ -119,6 +126,11 @@ const char* get_selected(HWND listbox) {
 Application::Application() {
     validate();
 
+    // Both run in the background from the start, so the system information
+    // panel opens instantly and with history
+    system_info.start();
+    sampler.start(settings.get<int>("sampler_period", 1000));
+
     // Used for help popup balloon
     InitCommonControls();
 
@@ -132,6 +144,14 @@ Application::Application() {
 
     RegisterClass(&wc);
 
+    WNDCLASS system_class = {};
+    system_class.lpfnWndProc = Application::SystemProc;
+    system_class.hInstance = wc.hInstance;
+    system_class.hCursor = LoadCursor(NULL, IDC_ARROW);
+    system_class.lpszClassName = SYSTEM_CLASS_NAME;
+
+    RegisterClass(&system_class);
+
     HFONT main_font = CreateFont(
         18,
         0,
@@ -163,7 +183,7 @@ Application::Application() {
     SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
 
     // Resize the window
-    MoveWindow(hwnd, 0, 0, (BUTTON_WIDTH * 2) + (10 * 5), 600, TRUE);
+    MoveWindow(hwnd, 0, 0, (BUTTON_WIDTH * 2) + (10 * 5), 770, TRUE);
 
     HWND running_button = CreateWindow(
         "BUTTON",
@@ -334,6 +354,21 @@ Application::Application() {
         NULL
     );
 
+    // Virtual list: rows are only formatted when they are painted
+    this->activity_list = CreateWindow(
+        WC_LISTVIEW,
+        nullptr,
+        WS_VISIBLE | WS_CHILD | LVS_REPORT | LVS_OWNERDATA | LVS_SINGLESEL,
+        PADDING,
+        170 + (BUTTON_HEIGHT * 4) + (PADDING * 3) + 200,
+        PADDING + (BUTTON_WIDTH * 2),
+        160,
+        hwnd,
+        (HMENU)Widgets::ACTIVITY,
+        wc.hInstance,
+        NULL
+    );
+
     widgets.push_back(running_button);
     widgets.push_back(taskkill_button);
     widgets.push_back(exit_button);
@@ -347,6 +382,7 @@ Application::Application() {
     widgets.push_back(take_snapshot);
     widgets.push_back(this->restore_snapshot);
     widgets.push_back(windows);
+    widgets.push_back(this->activity_list);
 
     tooltip(hwnd, running_button, "Toggle between DieKnow running or stopped.");
     tooltip(hwnd, taskkill_button, "Terminate the selected executable in the listbox.");
@@ -356,8 +392,9 @@ Application::Application() {
     tooltip(hwnd, interval_set, "Set the interval between ticks for closing DyKnow. Beware - an interval of 0 can saturate a CPU core.");
     tooltip(hwnd, executables_killed, "Number of DyKnow executables terminated by DieKnow.");
     tooltip(hwnd, open_explorer, "Open the DyKnow file directory in the Windows Explorer.");
-    tooltip(hwnd, display_information, "Show system information.");
+    tooltip(hwnd, display_information, "Show system information and DieKnow's live resource usage.");
     tooltip(hwnd, take_snapshot, "Take a snapshot of the current windows to restore them later on.");
+    tooltip(hwnd, this->activity_list, "Processes terminated by DieKnow, newest first.");
 
     for (HWND widget : widgets) {
         SendMessage(widget, WM_SETFONT, (WPARAM)main_font, TRUE);
@@ -379,11 +416,29 @@ Application::Application() {
         LVS_EX_FULLROWSELECT
     );
 
+    const char* activity_titles[] = {"Time", "Process", "PID", "Latency", "Result"};
+    const int activity_widths[] = {70, 140, 55, 60, 85};
+
+    for (int i = 0; i < 5; i++) {
+        LVCOLUMN column = {0};
+        column.mask = LVCF_TEXT | LVCF_WIDTH;
+        column.pszText = const_cast<char*>(activity_titles[i]);
+        column.cx = activity_widths[i];
+
+        SendMessage(this->activity_list, LVM_INSERTCOLUMN, i, (LPARAM)&column);
+    }
+    ListView_SetExtendedListViewStyle(
+        this->activity_list,
+        LVS_EX_GRIDLINES |
+        LVS_EX_FULLROWSELECT |
+        LVS_EX_DOUBLEBUFFER
+    );
+
     std::string status = running ? "Stop" : "Start";
     SetWindowText(this->widgets[Widgets::RUNNING], status.c_str());
 
-    // In ms -- set to 5 ticks per second
-    SetTimer(hwnd, 1, settings.get<int>("update", 100), nullptr);
+    power.request_recheck();
+    this->schedule_refresh(hwnd);
 
     ShowWindow(hwnd, SW_SHOW);
     UpdateWindow(hwnd);
@@ -395,6 +450,7 @@ Application::Application() {
     }
 
     this->hide_snapshots();
+    sampler.stop();
 }
 
 void Application::manage_command(Application* app, HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
@@ -484,30 +540,14 @@ void Application::manage_command(Application* app, HWND hwnd, UINT uMsg, WPARAM
         }
 
         case Widgets::SYSTEM_INFORMATION: {
-            std::string cpu_name = get_cpu_name();
-            std::string gpu_name = get_gpu_name();
-            std::string os_info = get_os_info();
-            std::string avaliable_ram = get_available_ram();
-
-            std::ostringstream message;
-            message << "SYSTEM INFORMATION" << "\n"
-                    << "==================" << "\n"
-                    << "CPU: " << cpu_name << "\n"
-                    << "GPU: " << gpu_name << "\n"
-                    << "Operating system: " << os_info << "\n"
-                    << "Free RAM: " << avaliable_ram;
-
-            MessageBox(hwnd, message.str().c_str(), "System Information", MB_OK | MB_ICONINFORMATION);
-
+            app->show_system_information();
             break;
         }
 
         case Widgets::TAKE_SNAPSHOT: {
             std::vector<Window> new_snapshot;
 
-            BOOL window_enumeration = EnumWindows(enum_snapshot, reinterpret_cast<LPARAM>(&new_snapshot));
-
-            if (!window_enumeration) {
+            if (!app->window_source->snapshot(new_snapshot)) {
                 std::ostringstream message;
                 message << "Failed to enumerate through windows."
                         << "Error: " << GetLastError();
@@ -602,9 +642,49 @@ LRESULT CALLBACK Application::WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LP
             break;
         }
 
+        case WM_NOTIFY: {
+            NMHDR* header = reinterpret_cast<NMHDR*>(lParam);
+
+            if (app && (header->idFrom == Widgets::ACTIVITY) && (header->code == LVN_GETDISPINFO)) {
+                app->describe_activity(reinterpret_cast<NMLVDISPINFO*>(lParam));
+                return 0;
+            }
+
+            break;
+        }
+
+        case WM_SIZE:
+            if (app) app->set_visibility(hwnd, wParam != SIZE_MINIMIZED, app->active);
+            break;
+
+        case WM_SHOWWINDOW:
+            if (app) app->set_visibility(hwnd, wParam != FALSE, app->active);
+            break;
+
+        case WM_ACTIVATE:
+            if (app) app->set_visibility(hwnd, app->visible, LOWORD(wParam) != WA_INACTIVE);
+            break;
+
+        case WM_POWERBROADCAST:
+            // Sent to every top-level window when the power source changes.
+            // The monitor thread reads it; the new profile applies to the
+            // refresh rate from its next tick.
+            if (app && (wParam == PBT_APMPOWERSTATUSCHANGE)) {
+                power.request_recheck();
+                app->schedule_refresh(hwnd);
+            }
+            return TRUE;
+
         case WM_TIMER:
             if (wParam == 1) {
+                auto start = std::chrono::steady_clock::now();
                 app->update(hwnd, uMsg, wParam, lParam);
+                update_duration.observe(std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start).count());
+
+                if ((refresh_limit > 0) && (++app->refreshes >= refresh_limit)) {
+                    DestroyWindow(hwnd);
+                }
             }
             return 0;
 
@@ -693,30 +773,27 @@ void Application::update(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
 
     EnableWindow(this->restore_snapshot, !this->snapshot.empty());
 
-    // Update directory listbox
-    std::vector<std::string> current_executables;
+    // Update directory listbox. Executables are compared by their target
+    // IDs, and the names shown come straight from the registry.
+    discovery.configure(settings);
+    discovery.scan(FOLDER_PATH, this->scanned);
 
-    for (const auto& entry : std::filesystem::directory_iterator(FOLDER_PATH)) {
-        if (entry.is_directory()) {
-            for (const auto& sub_entry : std::filesystem::directory_iterator(entry.path())) {
-                if ((sub_entry.is_regular_file()) &&
-                    (sub_entry.path().extension() == ".exe")) {
-                    current_executables.push_back(sub_entry.path().filename().string());
-                }
-            }
-        }
+    this->current_targets.clear();
+    for (const auto& target : this->scanned) {
+        uint32_t id = registry.intern(target.name);
+        if (id != TARGET_NONE) this->current_targets.push_back(id);
     }
 
-    if (!(current_executables == previous_executables)) {
-        previous_executables = current_executables;
+    if (!(this->current_targets == this->previous_targets)) {
+        this->previous_targets.swap(this->current_targets);
 
         SendMessage(widgets[Widgets::DIRECTORY], LB_RESETCONTENT, 0, 0);
 
-        for (const std::string& file_name : current_executables) {
+        for (uint32_t id : this->previous_targets) {
             SendMessage(
                 widgets[Widgets::DIRECTORY],
                 LB_ADDSTRING, 0,
-                (LPARAM)file_name.c_str());
+                (LPARAM)registry.get_name(id));
         }
     }
 
@@ -724,7 +801,7 @@ void Application::update(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
 
     std::vector<Window> current_windows;
 
-    EnumWindows(enum_windows, reinterpret_cast<LPARAM>(&current_windows));
+    this->window_source->list(current_windows);
 
     // this->update_windows(current_windows);
 
@@ -767,53 +844,370 @@ void Application::update(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
 
     this->update_windows(current_windows);
 
-    settings.update();
+    if (settings.update()) {
+        engine.publish(Events::SETTINGS_RELOADED, 0, "./settings.conf");
+    }
+
+    int interval = settings.get<int>("interval", 0);
 
-    if ((GetFocus() != widgets[Widgets::INTERVAL]) ||
-        (GetFocus() != widgets[Widgets::INTERVAL_SET])) {
+    if (((GetFocus() != widgets[Widgets::INTERVAL]) ||
+         (GetFocus() != widgets[Widgets::INTERVAL_SET])) &&
+        (interval != this->shown_interval)) {
+        this->shown_interval = interval;
         SetWindowText(
             widgets[Widgets::INTERVAL],
-            std::to_string(settings.get<int>("interval", 0)).c_str()
+            std::to_string(interval).c_str()
+        );
+    }
+
+    int count = get_killed_count();
+
+    if (count != this->shown_killed) {
+        this->shown_killed = count;
+
+        std::string message = "Executables terminated: " + std::to_string(count);
+        SetWindowText(
+            widgets[Widgets::EXECUTABLES_KILLED],
+            message.c_str()
         );
     }
 
-    std::string message = "Executables terminated: " + std::to_string(get_killed_count());
-    SetWindowText(
-        widgets[Widgets::EXECUTABLES_KILLED],
-        message.c_str()
+    this->update_activity();
+
+    // Picks up changes to the update settings
+    this->schedule_refresh(hwnd);
+}
+
+void Application::set_visibility(HWND hwnd, bool visible, bool active) {
+    /*
+    Track whether the window is visible and focused, and retime the refresh
+    timer to match.
+
+    Coming back into view refreshes once straight away, so the window never
+    shows data from while it was hidden or in the background.
+    */
+
+    bool stale = (visible && !this->visible) || (active && !this->active);
+
+    this->visible = visible;
+    this->active = active;
+
+    if (stale && visible) this->update(hwnd, WM_TIMER, 1, 0);
+
+    this->schedule_refresh(hwnd);
+}
+
+void Application::schedule_refresh(HWND hwnd) {
+    /*
+    Start, retime or stop the refresh timer.
+
+    All periodic GUI work runs from this one timer. It is stopped while the
+    window is minimized or hidden, and slowed to `background_update` while
+    another window has focus and may be covering it. On battery the
+    `battery_` periods are used, so the GUI wakes the CPU less often. The
+    timer is only reset when the period changes.
+    */
+
+    if (!this->visible) {
+        if (this->refresh != 0) KillTimer(hwnd, 1);
+        this->refresh = 0;
+        return;
+    }
+
+    int period = std::max(10, power.get<int>(settings, "update", 100));
+    if (!this->active) {
+        period = std::max(period, power.get<int>(settings, "background_update", 2000));
+    }
+
+    if (period == this->refresh) return;
+
+    this->refresh = period;
+    SetTimer(hwnd, 1, period, nullptr);
+}
+
+void Application::update_activity() {
+    /*
+    Move finished kills from the monitor's activity ring into the activity
+    list.
+
+    The list is virtual, so only the row count changes here; rows are
+    formatted by `describe_activity()` when Windows paints them. Nothing is
+    repainted if no kills finished.
+    */
+
+    static Activity drained[ACTIVITY_CAPACITY];
+
+    std::size_t count = activity.drain(drained, ACTIVITY_CAPACITY);
+    if (count == 0) return;
+
+    for (std::size_t i = 0; i < count; i++) {
+        this->history.push_back(drained[i]);
+    }
+    while (this->history.size() > ACTIVITY_HISTORY) {
+        this->history.pop_front();
+    }
+
+    ListView_SetItemCountEx(
+        this->activity_list,
+        static_cast<int>(this->history.size()),
+        LVSICF_NOSCROLL
     );
 }
 
+void Application::describe_activity(NMLVDISPINFO* info) {
+    /*
+    Fill in one cell of the activity list, which shows the newest kill
+    first.
+    */
+
+    LVITEM& item = info->item;
+    if (!(item.mask & LVIF_TEXT)) return;
+
+    std::size_t row = static_cast<std::size_t>(item.iItem);
+    if (row >= this->history.size()) return;
+
+    const Activity& entry = this->history[this->history.size() - 1 - row];
+
+    switch (item.iSubItem) {
+        case 0: {
+            time_t seconds = static_cast<time_t>(entry.timestamp / 1000);
+            tm local = {};
+            localtime_s(&local, &seconds);
+            strftime(item.pszText, item.cchTextMax, "%H:%M:%S", &local);
+            break;
+        }
+
+        case 1:
+            snprintf(item.pszText, item.cchTextMax, "%s", entry.name);
+            break;
+
+        case 2:
+            snprintf(item.pszText, item.cchTextMax, "%u", entry.pid);
+            break;
+
+        case 3:
+            snprintf(item.pszText, item.cchTextMax, "%u ms", entry.latency);
+            break;
+
+        case 4:
+            if (entry.result == Kills::CONFIRMED) {
+                snprintf(item.pszText, item.cchTextMax, "Terminated");
+            }
+            else {
+                snprintf(item.pszText, item.cchTextMax, "Gave up (%u)", entry.attempts);
+            }
+            break;
+    }
+}
+
 void Application::update_windows(std::vector<Window>& current_windows) {
-    for (size_t i = 0; i < current_windows.size(); ++i) {
-        const auto& window = current_windows[i];
-        HWND target = FindWindow(NULL, window.title.c_str());
-
-        if (target) {
-            int index = -1;
-            for (int j = 0; j < ListView_GetItemCount(this->windows); ++j) {
-                char text[256];
-                ListView_GetItemText(this->windows, j, 0, text, sizeof(text));
-
-                if (window.title == text) {
-                    index = j;
-                    break;
-                }
+    /*
+    Check the windows in the window list that are visible.
+
+    The list holds `current_windows` in order, so each window's row is its
+    index.
+    */
+
+    int count = ListView_GetItemCount(this->windows);
+
+    for (int i = 0; (i < count) && (i < static_cast<int>(current_windows.size())); i++) {
+        ListView_SetCheckState(this->windows, i, current_windows[i].visible ? TRUE : FALSE);
+    }
+}
+
+LRESULT CALLBACK Application::SystemProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
+    /*
+    Manage the events of the system information panel.
+    */
+
+    Application* app = reinterpret_cast<Application*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
+
+    switch (uMsg) {
+        case WM_TIMER:
+            InvalidateRect(hwnd, nullptr, FALSE);
+            return 0;
+
+        case WM_ERASEBKGND:
+            // Painted whole by `paint_system_information()`
+            return 1;
+
+        case WM_PAINT:
+            if (app) {
+                app->paint_system_information(hwnd);
+                return 0;
             }
+            break;
 
-            if (index >= 0) {
-                if (IsWindowVisible(target)) {
-                    ListView_SetCheckState(this->windows, index, TRUE);
-                }
-                else {
-                    ListView_SetCheckState(this->windows, index, FALSE);
-                }
+        case WM_DESTROY:
+            KillTimer(hwnd, 1);
+            if (app) app->system_window = nullptr;
+            return 0;
+    }
+
+    return DefWindowProc(hwnd, uMsg, wParam, lParam);
+}
+
+void Application::show_system_information() {
+    /*
+    Open the system information panel, or bring it to the front if it is
+    already open.
+
+    The panel repaints from the cached system information and the sampler's
+    ring as often as the sampler samples, and does no work once closed.
+    */
+
+    if (this->system_window) {
+        SetForegroundWindow(this->system_window);
+        return;
+    }
+
+    this->system_window = CreateWindowEx(
+        WS_EX_TOOLWINDOW,
+        SYSTEM_CLASS_NAME,
+        "System Information",
+        WS_OVERLAPPEDWINDOW & ~(WS_MAXIMIZEBOX),
+        CW_USEDEFAULT, CW_USEDEFAULT, SYSTEM_WIDTH, SYSTEM_HEIGHT,
+        this->hwnd, NULL, GetModuleHandle(NULL), NULL);
+
+    if (!this->system_window) return;
+
+    SetWindowLongPtr(this->system_window, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+    SetTimer(this->system_window, 1, std::max(250, settings.get<int>("sampler_period", 1000)), nullptr);
+
+    ShowWindow(this->system_window, SW_SHOW);
+}
+
+void Application::paint_system_information(HWND hwnd) {
+    /*
+    Paint the system information panel: the cached hardware and OS names,
+    the newest sample, and a graph of the machine's and DieKnow's CPU usage
+    over the whole ring.
+
+    Painted into a memory bitmap first, so the graph doesn't flicker.
+    */
+
+    PAINTSTRUCT paint;
+    HDC screen = BeginPaint(hwnd, &paint);
+
+    RECT client;
+    GetClientRect(hwnd, &client);
+
+    HDC dc = CreateCompatibleDC(screen);
+    HBITMAP bitmap = CreateCompatibleBitmap(screen, client.right, client.bottom);
+    HGDIOBJ old_bitmap = SelectObject(dc, bitmap);
+    HGDIOBJ old_font = SelectObject(dc, GetStockObject(DEFAULT_GUI_FONT));
+
+    FillRect(dc, &client, reinterpret_cast<HBRUSH>(COLOR_BTNFACE + 1));
+    SetBkMode(dc, TRANSPARENT);
+
+    int y = PADDING;
+    char line[512];
+
+    auto text = [&](COLORREF color) {
+        SetTextColor(dc, color);
+        TextOut(dc, PADDING, y, line, static_cast<int>(strlen(line)));
+        y += 18;
+    };
+
+    const COLORREF BLACK = RGB(0, 0, 0);
+    const COLORREF SYSTEM_COLOR = RGB(0, 90, 200);
+    const COLORREF OWN_COLOR = RGB(200, 30, 30);
+
+    if (this->system_info.is_ready()) {
+        snprintf(line, sizeof(line), "CPU: %s", this->system_info.get_cpu().c_str());
+        text(BLACK);
+        snprintf(line, sizeof(line), "GPU: %s", this->system_info.get_gpu().c_str());
+        text(BLACK);
+        snprintf(line, sizeof(line), "Operating system: %s", this->system_info.get_os().c_str());
+        text(BLACK);
+    }
+    else {
+        snprintf(line, sizeof(line), "Gathering system information...");
+        text(BLACK);
+        y += 36;
+    }
+
+    y += PADDING;
+
+    ResourceSample samples[SAMPLER_CAPACITY];
+    std::size_t count = this->sampler.copy(samples, SAMPLER_CAPACITY);
+
+    if (count > 0) {
+        const ResourceSample& latest = samples[count - 1];
+
+        double peak = 0;
+        double total = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            peak = std::max(peak, samples[i].own_cpu);
+            total += samples[i].own_cpu;
+        }
+
+        snprintf(line, sizeof(line), "System CPU: %.1f%%", latest.system_cpu);
+        text(SYSTEM_COLOR);
+        snprintf(line, sizeof(line), "DieKnow CPU: %.2f%% (%.2f%% average, %.2f%% peak over %llu s)",
+                 latest.own_cpu, total / static_cast<double>(count), peak,
+                 static_cast<unsigned long long>((latest.timestamp - samples[0].timestamp) / 1000));
+        text(OWN_COLOR);
+        snprintf(line, sizeof(line), "Free RAM: %llu of %llu MB",
+                 static_cast<unsigned long long>(latest.free_ram / (1024 * 1024)),
+                 static_cast<unsigned long long>(latest.total_ram / (1024 * 1024)));
+        text(BLACK);
+        snprintf(line, sizeof(line), "DieKnow memory: %.1f MB",
+                 static_cast<double>(latest.own_rss) / (1024 * 1024));
+        text(BLACK);
+    }
+    else {
+        snprintf(line, sizeof(line), "Sampling is disabled (see `sampler_period`).");
+        text(BLACK);
+    }
+
+    // CPU usage graph from 0% to 100%, newest sample on the right
+    RECT graph = {PADDING, y + PADDING, client.right - PADDING, client.bottom - PADDING};
+
+    if ((graph.bottom - graph.top > 20) && (graph.right - graph.left > 20)) {
+        FillRect(dc, &graph, reinterpret_cast<HBRUSH>(COLOR_WINDOW + 1));
+        FrameRect(dc, &graph, reinterpret_cast<HBRUSH>(GetStockObject(GRAY_BRUSH)));
+
+        int width = graph.right - graph.left - 2;
+        int height = graph.bottom - graph.top - 2;
+
+        POINT points[SAMPLER_CAPACITY];
+
+        for (int series = 0; series < 2; series++) {
+            HPEN pen = CreatePen(PS_SOLID, 2, series ? OWN_COLOR : SYSTEM_COLOR);
+            HGDIOBJ old_pen = SelectObject(dc, pen);
+
+            for (std::size_t i = 0; i < count; i++) {
+                double value = series ? samples[i].own_cpu : samples[i].system_cpu;
+                value = std::min(100.0, std::max(0.0, value));
+
+                std::size_t slot = SAMPLER_CAPACITY - count + i;
+                points[i].x = graph.left + 1 + static_cast<LONG>(slot * width / (SAMPLER_CAPACITY - 1));
+                points[i].y = graph.bottom - 1 - static_cast<LONG>(value * height / 100.0);
             }
+
+            if (count > 1) Polyline(dc, points, static_cast<int>(count));
+
+            SelectObject(dc, old_pen);
+            DeleteObject(pen);
         }
     }
+
+    BitBlt(screen, 0, 0, client.right, client.bottom, dc, 0, 0, SRCCOPY);
+
+    SelectObject(dc, old_font);
+    SelectObject(dc, old_bitmap);
+    DeleteObject(bitmap);
+    DeleteDC(dc);
+
+    EndPaint(hwnd, &paint);
 }
 
 DK_API void create_window() {
+    /*
+    Open the DieKnow GUI and block until it is closed.
+    */
+
     SetUnhandledExceptionFilter(ExceptionHandler);
 
     Application* application = new Application();
@@ -824,3 +1218,25 @@ DK_API void create_window() {
 
     delete application;
 }
+
+DK_API double profile_window(int refreshes) {
+    /*
+    Open the GUI, let it refresh `refreshes` times at the period of the
+    `update` setting, then close it. Returns the average time of a refresh
+    in milliseconds.
+
+    This drives `Application::update()` without anybody clicking, to train
+    and measure the optimized build (see tests/profile.py).
+    */
+
+    refresh_limit = std::max(1, refreshes);
+    create_window();
+    refresh_limit = 0;
+
+    uint64_t count = 0;
+    for (int bucket = 0; bucket <= METRICS_BUCKETS; bucket++) {
+        count += update_duration.get_count(bucket);
+    }
+
+    return count ? (update_duration.get_sum() * 1000.0 / static_cast<double>(count)) : 0.0;
+}
@@ -29,10 +29,34 @@ VERSION: 1.0.1
 #include <windows.h>
 #include <commctrl.h>
 #include <unordered_map>
+#include <deque>
+#include <chrono>
+#include <memory>
 
 #include "api.cpp"
 #include "system.cpp"
+#include "window.cpp"
 #include "settings.cpp"
+#include "events.cpp"
+#include "discovery.cpp"
+#include "identity.cpp"
+#include "process.cpp"
+#include "handles.cpp"
+#include "termination.cpp"
+#include "roots.cpp"
+#include "governor.cpp"
+#include "scheduling.cpp"
+#include "power.cpp"
+#include "activity.cpp"
+#include "shared.cpp"
+#include "pipe.cpp"
+#include "metrics.cpp"
+#include "journal.cpp"
+#include "clock.cpp"
+#include "watcher.cpp"
+#include "registry.cpp"
+#include "engine.cpp"
+#include "sampler.cpp"
 
 // Or more correctly, widget dimensions
 const int BUTTON_WIDTH = 200;
@@ -41,6 +65,14 @@ const int BUTTON_HEIGHT = 35;
 // Space between widgets as padding
 const int PADDING = 10;
 
+// Most finished kills kept in the activity list
+const std::size_t ACTIVITY_HISTORY = 1000;
+
+// Window class and size of the system information panel
+const char SYSTEM_CLASS_NAME[] = "DieKnowSystemInformation";
+const int SYSTEM_WIDTH = 520;
+const int SYSTEM_HEIGHT = 400;
+
 
 namespace Widgets {
     enum Button {
@@ -57,12 +89,14 @@ namespace Widgets {
         SYSTEM_INFORMATION,
         TAKE_SNAPSHOT,
         RESTORE_SNAPSHOT,
+        ACTIVITY,
     };
 }
 
 
 extern "C" {
     DK_API void create_window();
+    DK_API double profile_window(int refreshes);
 }
 
 void tooltip(HWND hwnd, HWND control, const char* text);
@@ -78,17 +112,49 @@ public:
     // Used to call `WM_SETFONT`
     std::vector<HWND> widgets;
 
-    // Used to determine whether or not to refresh the listbox
-    std::vector<std::string> previous_executables;
+    // Used to determine whether or not to refresh the listbox: target IDs
+    // of the executables shown, and of those just found, with the targets
+    // they were found from. Kept across refreshes so none allocate.
+    std::vector<uint32_t> previous_targets;
+    std::vector<uint32_t> current_targets;
+    std::vector<Target> scanned;
     std::vector<Window> previous_windows;
     std::vector<Window> snapshot;
 
+    // Lists the desktop's windows for the window list and snapshots
+    std::unique_ptr<WindowSource> window_source = create_window_source();
+
     HWND hwnd;
     HWND windows;
     HWND restore_snapshot;
+    HWND activity_list;
+
+    // Finished kills drained from `activity`, oldest first
+    std::deque<Activity> history;
+
+    // Last values written to the labels, so unchanged ones aren't repainted
+    int shown_killed = -1;
+    int shown_interval = -1;
 
     bool is_restoring = false;
 
+    // Refresh timer period in milliseconds, which follows the power profile,
+    // or 0 while the timer is stopped
+    int refresh = 0;
+
+    // Whether anybody can see the window, and whether it has focus
+    bool visible = true;
+    bool active = true;
+
+    // Timer refreshes so far, counted towards `refresh_limit`
+    int refreshes = 0;
+
+    // Shown in the system information panel, which is only open while
+    // `system_window` is set
+    SystemInfo system_info;
+    ResourceSampler sampler;
+    HWND system_window = nullptr;
+
     Application();
 
     void manage_command(Application* app, HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
@@ -102,7 +168,18 @@ public:
 
     void update(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 
+    void schedule_refresh(HWND hwnd);
+    void set_visibility(HWND hwnd, bool visible, bool active);
+
     void update_windows(std::vector<Window>& current_windows);
+
+    void update_activity();
+    void describe_activity(NMLVDISPINFO* info);
+
+    static LRESULT CALLBACK SystemProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+
+    void show_system_information();
+    void paint_system_information(HWND hwnd);
 };
 
 #endif // GUI_H
@@ -0,0 +1,272 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/handles.cpp
+DESCRIPTION: Cache of open process handles
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "handles.h"
+
+#include <algorithm>
+#include <utility>
+
+#ifndef _WIN32
+#include <csignal>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+
+ProcessHandle open_process(uint32_t pid) {
+    /*
+    Open a handle that can both terminate a process and wait for its exit.
+    */
+
+#ifdef _WIN32
+    return OpenProcess(SYNCHRONIZE | PROCESS_TERMINATE, FALSE, pid);
+#else
+    return static_cast<int>(syscall(SYS_pidfd_open, static_cast<pid_t>(pid), 0));
+#endif
+}
+
+void close_process(ProcessHandle handle) {
+#ifdef _WIN32
+    if (handle) CloseHandle(handle);
+#else
+    if (handle >= 0) close(handle);
+#endif
+}
+
+bool signal_terminate(ProcessHandle handle) {
+    /*
+    Ask a process to terminate without waiting for it.
+
+    On Windows this is `TerminateProcess()`; elsewhere SIGKILL is sent through
+    the pidfd, so it can never reach a process that reused the PID.
+    */
+
+#ifdef _WIN32
+    return TerminateProcess(handle, 0) != 0;
+#else
+    return syscall(SYS_pidfd_send_signal, handle, SIGKILL, nullptr, 0) == 0;
+#endif
+}
+
+#ifdef _WIN32
+static BOOL CALLBACK close_window(HWND hwnd, LPARAM param) {
+    auto* request = reinterpret_cast<std::pair<DWORD, bool>*>(param);
+
+    DWORD owner = 0;
+    GetWindowThreadProcessId(hwnd, &owner);
+
+    if ((owner == request->first) && IsWindowVisible(hwnd)) {
+        PostMessage(hwnd, WM_CLOSE, 0, 0);
+        request->second = true;
+    }
+
+    return TRUE;
+}
+#endif
+
+bool signal_close(ProcessHandle handle, uint32_t pid) {
+    /*
+    Ask a process to close itself without waiting for it.
+
+    On Windows every visible top-level window of the process is sent
+    `WM_CLOSE`; elsewhere SIGTERM is sent through the pidfd. Returns false if
+    there was nothing to ask, e.g. a windowless process.
+    */
+
+#ifdef _WIN32
+    (void)handle;
+    std::pair<DWORD, bool> request(pid, false);
+    EnumWindows(close_window, reinterpret_cast<LPARAM>(&request));
+    return request.second;
+#else
+    (void)pid;
+    return syscall(SYS_pidfd_send_signal, handle, SIGTERM, nullptr, 0) == 0;
+#endif
+}
+
+bool wait_exit(ProcessHandle handle, int timeout) {
+    /*
+    Wait up to `timeout` milliseconds for a process to exit.
+
+    A timeout of 0 only checks, without blocking.
+    */
+
+#ifdef _WIN32
+    return WaitForSingleObject(handle, static_cast<DWORD>(timeout)) == WAIT_OBJECT_0;
+#else
+    pollfd descriptor = {handle, POLLIN, 0};
+    return poll(&descriptor, 1, timeout) > 0;
+#endif
+}
+
+ProcessControl& system_process_control() {
+    static SystemProcessControl control;
+    return control;
+}
+
+HandleCache::HandleCache(std::size_t capacity, ProcessControl* control)
+    : capacity(std::max<std::size_t>(1, capacity)),
+      control(control ? control : &system_process_control()) {}
+
+HandleCache::~HandleCache() {
+    for (auto& [pid, entry] : entries) control->close(entry.handle);
+}
+
+void HandleCache::evict_oldest() {
+    // Caller must hold `mutex`. The cache is small, so a linear scan is fine.
+    auto oldest = entries.end();
+
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if ((oldest == entries.end()) || (it->second.last_used < oldest->second.last_used)) {
+            oldest = it;
+        }
+    }
+
+    if (oldest != entries.end()) {
+        control->close(oldest->second.handle);
+        entries.erase(oldest);
+    }
+}
+
+ProcessHandle HandleCache::checkout(uint32_t pid, uint64_t create_time) {
+    /*
+    Take a handle to a process out of the cache, opening one only if it isn't
+    cached.
+
+    A cached handle is reused only while its process is still alive and has
+    the same creation time (when the backend reports one), so a reused PID
+    never gets a handle to the wrong process. The caller owns the handle until
+    it is checked back in or closed.
+    */
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    clock++;
+
+    auto it = entries.find(pid);
+    if (it != entries.end()) {
+        Entry& entry = it->second;
+
+        bool same = (create_time == 0) || (entry.create_time == 0) ||
+                    (entry.create_time == create_time);
+
+        if (same && !control->wait(entry.handle, 0)) {
+            ProcessHandle handle = entry.handle;
+            entries.erase(it);
+            hits++;
+            return handle;
+        }
+
+        control->close(entry.handle);
+        entries.erase(it);
+    }
+
+    misses++;
+
+    return control->open(pid);
+}
+
+void HandleCache::checkin(uint32_t pid, uint64_t create_time, ProcessHandle handle) {
+    /*
+    Give a handle back to the cache, usually because its process survived a
+    kill and will be targeted again.
+    */
+
+    if (handle == INVALID_PROCESS_HANDLE) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    clock++;
+
+    auto it = entries.find(pid);
+    if (it != entries.end()) {
+        control->close(it->second.handle);
+        entries.erase(it);
+    }
+
+    while (entries.size() >= capacity) evict_oldest();
+
+    entries[pid] = {create_time, handle, clock};
+}
+
+void HandleCache::evict(uint32_t pid) {
+    /*
+    Close and forget the handle to a process, usually once it has exited.
+    */
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = entries.find(pid);
+    if (it == entries.end()) return;
+
+    control->close(it->second.handle);
+    entries.erase(it);
+}
+
+std::size_t HandleCache::prune() {
+    /*
+    Evict the handles of every cached process that has exited.
+
+    Checking a handle is a single non-blocking wait, so this is cheap enough
+    to run every sweep. Returns the amount of handles evicted.
+    */
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::size_t evicted = 0;
+
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (control->wait(it->second.handle, 0)) {
+            control->close(it->second.handle);
+            it = entries.erase(it);
+            evicted++;
+        }
+        else {
+            ++it;
+        }
+    }
+
+    return evicted;
+}
+
+void HandleCache::resize(std::size_t size) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    capacity = std::max<std::size_t>(1, size);
+    while (entries.size() > capacity) evict_oldest();
+}
+
+std::size_t HandleCache::get_hits() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+}
+
+std::size_t HandleCache::get_misses() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+}
+
+std::size_t HandleCache::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
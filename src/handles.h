@@ -0,0 +1,115 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/handles.h
+DESCRIPTION: Cache of open process handles
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef HANDLES_H
+#define HANDLES_H
+
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include <mutex>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+
+#ifdef _WIN32
+typedef HANDLE ProcessHandle;
+#define INVALID_PROCESS_HANDLE nullptr
+#else
+// A pidfd, which stays bound to its process even if the PID is reused
+typedef int ProcessHandle;
+#define INVALID_PROCESS_HANDLE -1
+#endif
+
+ProcessHandle open_process(uint32_t pid);
+
+void close_process(ProcessHandle handle);
+
+bool signal_terminate(ProcessHandle handle);
+
+bool signal_close(ProcessHandle handle, uint32_t pid);
+
+bool wait_exit(ProcessHandle handle, int timeout);
+
+// How kills reach processes, so a test or replay can run the terminator and
+// handle cache on processes of its own
+class ProcessControl {
+public:
+    virtual ~ProcessControl() = default;
+
+    virtual ProcessHandle open(uint32_t pid) = 0;
+    virtual void close(ProcessHandle handle) = 0;
+    virtual bool terminate(ProcessHandle handle) = 0;
+    virtual bool request_close(ProcessHandle handle, uint32_t pid) = 0;
+    virtual bool wait(ProcessHandle handle, int timeout) = 0;
+};
+
+// The real processes of the machine, through the functions above
+class SystemProcessControl : public ProcessControl {
+public:
+    ProcessHandle open(uint32_t pid) override { return open_process(pid); }
+    void close(ProcessHandle handle) override { close_process(handle); }
+    bool terminate(ProcessHandle handle) override { return signal_terminate(handle); }
+    bool request_close(ProcessHandle handle, uint32_t pid) override { return signal_close(handle, pid); }
+    bool wait(ProcessHandle handle, int timeout) override { return wait_exit(handle, timeout); }
+};
+
+ProcessControl& system_process_control();
+
+class HandleCache {
+    struct Entry {
+        uint64_t create_time;
+        ProcessHandle handle;
+        uint64_t last_used;
+    };
+
+    std::unordered_map<uint32_t, Entry> entries;
+    std::size_t capacity;
+    ProcessControl* control;
+    uint64_t clock = 0;
+
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+
+    std::mutex mutex;
+
+    void evict_oldest();
+
+public:
+    explicit HandleCache(std::size_t capacity = 32, ProcessControl* control = nullptr);
+    ~HandleCache();
+
+    ProcessHandle checkout(uint32_t pid, uint64_t create_time);
+    void checkin(uint32_t pid, uint64_t create_time, ProcessHandle handle);
+    void evict(uint32_t pid);
+    std::size_t prune();
+
+    void resize(std::size_t size);
+
+    std::size_t get_hits();
+    std::size_t get_misses();
+    std::size_t size();
+};
+
+#endif // HANDLES_H
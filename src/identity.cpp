@@ -0,0 +1,372 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/identity.cpp
+DESCRIPTION: Content identity cache for target executables
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "identity.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+
+static inline uint64_t mix(uint64_t value) {
+    // Final avalanche from MurmurHash3, so every input bit affects the result
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDULL;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+bool hash_file(const std::string& path, uint64_t& hash) {
+    /*
+    Compute a fast 64-bit content hash of a file.
+
+    The file is read in 64 KB blocks and folded eight bytes at a time. This is
+    not a cryptographic hash; it only has to tell executables apart quickly.
+    */
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    static thread_local char block[64 * 1024];
+
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    uint64_t length = 0;
+
+    while (file) {
+        file.read(block, sizeof(block));
+        std::streamsize amount = file.gcount();
+        if (amount <= 0) break;
+
+        std::streamsize i = 0;
+        for (; i + 8 <= amount; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, block + i, sizeof(word));
+            state = (state ^ mix(word)) * 0x100000001B3ULL;
+        }
+
+        // Fold any trailing bytes into one final word
+        if (i < amount) {
+            uint64_t word = 0;
+            std::memcpy(&word, block + i, static_cast<std::size_t>(amount - i));
+            state = (state ^ mix(word)) * 0x100000001B3ULL;
+        }
+
+        length += static_cast<uint64_t>(amount);
+    }
+
+    hash = mix(state ^ length);
+    return true;
+}
+
+bool IdentityCache::stat(const std::string& path, uint64_t& size, int64_t& mtime) const {
+    /*
+    Read the size and modification time of a file.
+
+    Every target is checked every sweep, so this calls the OS directly
+    rather than building a `std::filesystem::path`, which would allocate.
+    */
+
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data)) return false;
+
+    size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    mtime = static_cast<int64_t>((static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) |
+                                 data.ftLastWriteTime.dwLowDateTime);
+#else
+    struct stat status;
+    if (::stat(path.c_str(), &status) != 0) return false;
+
+    size = static_cast<uint64_t>(status.st_size);
+    mtime = (static_cast<int64_t>(status.st_mtim.tv_sec) * 1000000000) + status.st_mtim.tv_nsec;
+#endif
+
+    return true;
+}
+
+bool IdentityCache::load(const std::string& file_name) {
+    /*
+    Load cached identities from a binary cache file.
+
+    Each record is the path, size, modification time and hash of a file. A
+    missing, truncated or outdated cache is not an error; files are simply
+    hashed again.
+    */
+
+    std::ifstream file(file_name, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t count = 0;
+
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+
+    if (!file || (magic != IDENTITY_MAGIC) || (version != IDENTITY_VERSION)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t length = 0;
+        file.read(reinterpret_cast<char*>(&length), sizeof(length));
+        if (!file || (length > 32768)) break;
+
+        std::string path(length, '\0');
+        Identity identity;
+
+        file.read(path.data(), length);
+        file.read(reinterpret_cast<char*>(&identity.size), sizeof(identity.size));
+        file.read(reinterpret_cast<char*>(&identity.mtime), sizeof(identity.mtime));
+        file.read(reinterpret_cast<char*>(&identity.hash), sizeof(identity.hash));
+        if (!file) break;
+
+        entries[path] = identity;
+    }
+
+    return true;
+}
+
+bool IdentityCache::save(const std::string& file_name) {
+    /*
+    Write the cache to disk if anything changed since it was last saved.
+
+    The cache is written to a temporary file first and then renamed over the
+    old one, so a crash can never leave a half-written cache behind. Entries
+    whose file no longer exists are dropped first, so the cache doesn't grow
+    with every binary ever hashed.
+    */
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!dirty) return true;
+
+    std::error_code ec;
+
+    for (auto it = entries.begin(); it != entries.end();) {
+        // A path that can't be checked is kept
+        if (std::filesystem::exists(it->first, ec) || ec) ++it;
+        else it = entries.erase(it);
+    }
+
+    std::string temporary = file_name + ".tmp";
+
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+
+        uint32_t magic = IDENTITY_MAGIC;
+        uint32_t version = IDENTITY_VERSION;
+        uint32_t count = static_cast<uint32_t>(entries.size());
+
+        file.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+        file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+
+        for (const auto& [path, identity] : entries) {
+            uint32_t length = static_cast<uint32_t>(path.size());
+
+            file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            file.write(path.data(), length);
+            file.write(reinterpret_cast<const char*>(&identity.size), sizeof(identity.size));
+            file.write(reinterpret_cast<const char*>(&identity.mtime), sizeof(identity.mtime));
+            file.write(reinterpret_cast<const char*>(&identity.hash), sizeof(identity.hash));
+        }
+
+        if (!file) return false;
+    }
+
+    std::filesystem::rename(temporary, file_name, ec);
+    if (ec) return false;
+
+    dirty = false;
+    return true;
+}
+
+void IdentityCache::refresh(const std::vector<Target>& discovered) {
+    /*
+    Bring the identities of the discovered targets up to date.
+
+    Only files that are new, or whose size or modification time changed, are
+    hashed. Those are hashed in parallel outside the lock. The set of target
+    hashes is then rebuilt from the discovered files, unless neither the
+    files nor the list of them changed.
+    */
+
+    struct Stale {
+        const Target* target;
+        Identity identity;
+        bool hashed;
+    };
+
+    std::vector<Stale> stale;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (const auto& target : discovered) {
+            Identity identity{};
+            if (!stat(target.path, identity.size, identity.mtime)) continue;
+
+            auto it = entries.find(target.path);
+            if ((it != entries.end()) &&
+                (it->second.size == identity.size) &&
+                (it->second.mtime == identity.mtime)) {
+                continue;
+            }
+
+            stale.push_back({&target, identity, false});
+        }
+    }
+
+    if (!stale.empty()) {
+        std::atomic<std::size_t> next{0};
+
+        auto work = [&]() {
+            std::size_t i;
+            while ((i = next++) < stale.size()) {
+                stale[i].hashed = hash_file(stale[i].target->path, stale[i].identity.hash);
+            }
+        };
+
+        std::size_t count = std::min<std::size_t>(
+            stale.size(),
+            std::max(1u, std::min(4u, std::thread::hardware_concurrency()))
+        );
+
+        std::vector<std::thread> threads;
+        for (std::size_t i = 1; i < count; i++) threads.emplace_back(work);
+        work();
+        for (auto& thread : threads) thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (const auto& item : stale) {
+        if (!item.hashed) continue;
+
+        entries[item.target->path] = item.identity;
+        dirty = true;
+    }
+
+    // Nothing to rebuild if no file changed and the same files were found,
+    // which is almost every sweep
+    bool same = stale.empty() && (refreshed.size() == discovered.size());
+    for (std::size_t i = 0; same && (i < discovered.size()); i++) {
+        same = (refreshed[i] == discovered[i].path);
+    }
+    if (same) return;
+
+    // Assigned in place, so existing strings keep their buffers
+    refreshed.resize(discovered.size());
+    for (std::size_t i = 0; i < discovered.size(); i++) refreshed[i] = discovered[i].path;
+
+    targets.clear();
+    sizes.clear();
+
+    for (const auto& target : discovered) {
+        auto it = entries.find(target.path);
+
+        // Every empty file hashes the same, so it can't identify anything
+        if ((it != entries.end()) && (it->second.size > 0)) {
+            targets.insert(it->second.hash);
+            sizes.insert(it->second.size);
+        }
+    }
+}
+
+bool IdentityCache::lookup(const std::string& path, uint64_t& hash) {
+    /*
+    Retrieve the content hash of any file, such as a running process' image.
+
+    The file is only read if it is not cached or has changed on disk.
+    */
+
+    Identity identity{};
+    if (!stat(path, identity.size, identity.mtime)) return false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto it = entries.find(path);
+        if ((it != entries.end()) &&
+            (it->second.size == identity.size) &&
+            (it->second.mtime == identity.mtime)) {
+            hash = it->second.hash;
+            return true;
+        }
+    }
+
+    if (!hash_file(path, identity.hash)) return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[path] = identity;
+    dirty = true;
+
+    hash = identity.hash;
+    return true;
+}
+
+bool IdentityCache::is_target(uint64_t hash) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return targets.count(hash) > 0;
+}
+
+bool IdentityCache::matches(const std::string& path) {
+    /*
+    Check if a file has the same contents as any discovered target.
+
+    A file can only match if its size equals a target's size, so files of any
+    other size are rejected from a single `stat()` without being read.
+    */
+
+    uint64_t size;
+    int64_t mtime;
+    if (!stat(path, size, mtime)) return false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (sizes.count(size) == 0) return false;
+    }
+
+    uint64_t hash;
+    return lookup(path, hash) && is_target(hash);
+}
+
+std::size_t IdentityCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
@@ -0,0 +1,75 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/identity.h
+DESCRIPTION: Content identity cache for target executables
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef IDENTITY_H
+#define IDENTITY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+
+#include "discovery.h"
+
+// Magic number at the start of the cache file, "DKIC" in little endian
+#define IDENTITY_MAGIC 0x43494B44
+#define IDENTITY_VERSION 2
+
+
+struct Identity {
+    uint64_t size;
+    int64_t mtime;
+    uint64_t hash;
+};
+
+bool hash_file(const std::string& path, uint64_t& hash);
+
+class IdentityCache {
+    // Keyed by path; an entry is only trusted while its size and modification
+    // time still match the file on disk
+    std::unordered_map<std::string, Identity> entries;
+    std::unordered_set<uint64_t> targets;
+    // Sizes of the targets, so files of any other size are never hashed
+    std::unordered_set<uint64_t> sizes;
+    // Paths `targets` and `sizes` were last built from
+    std::vector<std::string> refreshed;
+
+    mutable std::mutex mutex;
+    bool dirty = false;
+
+    bool stat(const std::string& path, uint64_t& size, int64_t& mtime) const;
+
+public:
+    bool load(const std::string& file_name);
+    bool save(const std::string& file_name);
+
+    void refresh(const std::vector<Target>& discovered);
+    bool lookup(const std::string& path, uint64_t& hash);
+
+    bool is_target(uint64_t hash) const;
+    bool matches(const std::string& path);
+    std::size_t size() const;
+};
+
+#endif // IDENTITY_H
@@ -0,0 +1,248 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/journal.cpp
+DESCRIPTION: Memory-mapped journal of engine events
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "journal.h"
+
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+Journal::~Journal() {
+    this->close();
+}
+
+void Journal::unmap() {
+    // Caller must hold `mutex`
+#ifdef _WIN32
+    if (header) UnmapViewOfFile(header);
+    if (mapping) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+#else
+    if (header) munmap(header, (capacity + 1) * sizeof(JournalRecord));
+    // Closing the file also drops the lock on it
+    if (file >= 0) ::close(file);
+    file = -1;
+#endif
+    header = nullptr;
+    records = nullptr;
+}
+
+bool Journal::map() {
+    /*
+    Map the journal file, creating and preallocating it if needed.
+
+    The file is locked for writing, so a second DieKnow instance can't
+    interleave records with this one; it just doesn't journal. Caller must
+    hold `mutex`.
+    */
+
+    std::size_t size = (capacity + 1) * sizeof(JournalRecord);
+    void* view = nullptr;
+
+    stale = false;
+
+#ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                       OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    // The mapping extends a shorter file to its full size with zeros
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+                                 static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                                 static_cast<DWORD>(size & 0xFFFFFFFF), nullptr);
+    if (mapping) view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+    file = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (file < 0) return false;
+
+    struct stat status;
+    bool ready = (flock(file, LOCK_EX | LOCK_NB) == 0) && (fstat(file, &status) == 0);
+
+    // Reserve the blocks up front so appends never hit a full disk or
+    // fragment the file
+    if (ready && (static_cast<std::size_t>(status.st_size) < size)) {
+        ready = (posix_fallocate(file, 0, static_cast<off_t>(size)) == 0) ||
+                (ftruncate(file, static_cast<off_t>(size)) == 0);
+    }
+
+    if (ready) view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (view == MAP_FAILED) view = nullptr;
+#endif
+
+    if (!view) {
+        unmap();
+        return false;
+    }
+
+    header = static_cast<JournalHeader*>(view);
+    records = reinterpret_cast<JournalRecord*>(header + 1);
+
+    if (header->magic == 0) {
+        header->version = JOURNAL_VERSION;
+        header->record_size = sizeof(JournalRecord);
+        header->capacity = capacity;
+        header->magic = JOURNAL_MAGIC;
+    }
+
+    if ((header->magic != JOURNAL_MAGIC) || (header->version != JOURNAL_VERSION) ||
+        (header->record_size != sizeof(JournalRecord)) || (header->capacity != capacity)) {
+        stale = true;
+        unmap();
+        return false;
+    }
+
+    // Records are only ever filled in order, so the first unused one can be
+    // found with a binary search instead of reading the whole file
+    std::size_t low = 0;
+    std::size_t high = capacity;
+    while (low < high) {
+        std::size_t middle = low + ((high - low) / 2);
+        if (records[middle].sequence != 0) low = middle + 1;
+        else high = middle;
+    }
+
+    next = low;
+    if (next > 0) sequence = records[next - 1].sequence + 1;
+
+    return true;
+}
+
+void Journal::rotate() {
+    /*
+    Shift `<path>` to `<path>.1`, `<path>.1` to `<path>.2` and so on, dropping
+    the oldest, then start a fresh file. Caller must hold `mutex`.
+    */
+
+    unmap();
+
+    std::error_code error;
+
+    if (files > 1) {
+        std::filesystem::remove(path + "." + std::to_string(files - 1), error);
+
+        for (int i = files - 2; i >= 1; i--) {
+            std::filesystem::rename(path + "." + std::to_string(i), path + "." + std::to_string(i + 1), error);
+        }
+
+        std::filesystem::rename(path, path + ".1", error);
+    }
+    else {
+        std::filesystem::remove(path, error);
+    }
+
+    map();
+}
+
+bool Journal::open(const std::string& journal_path, std::size_t journal_capacity, int journal_files) {
+    /*
+    Start journaling to `journal_path`, keeping up to `journal_capacity`
+    records per file and `journal_files` files in total.
+
+    An existing journal is appended to. One written with another layout or
+    capacity is rotated away rather than overwritten. Reopening with the same
+    arguments does nothing.
+    */
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    journal_capacity = std::max<std::size_t>(1, journal_capacity);
+    journal_files = std::max(1, journal_files);
+
+    if (records && (path == journal_path) && (capacity == journal_capacity)) {
+        files = journal_files;
+        return true;
+    }
+
+    unmap();
+
+    path = journal_path;
+    capacity = journal_capacity;
+    files = journal_files;
+
+    if (map()) return true;
+
+    // A journal locked by another instance is left alone
+    if (!stale) return false;
+
+    rotate();
+    return records != nullptr;
+}
+
+void Journal::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    unmap();
+}
+
+bool Journal::is_open() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return records != nullptr;
+}
+
+void Journal::append(int type, uint32_t pid, const char* name, uint32_t value, uint32_t count) {
+    /*
+    Append a record. Does nothing if the journal isn't open.
+
+    An append is a handful of stores into the mapping; the OS writes the
+    pages back on its own, so records survive a crash of DieKnow itself
+    without any syscall per record.
+    */
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!records) return;
+
+    if (next >= capacity) {
+        rotate();
+        if (!records) return;
+    }
+
+    JournalRecord& record = records[next];
+
+    record.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    record.type = static_cast<uint16_t>(type);
+    record.reserved = 0;
+    record.pid = pid;
+    record.value = value;
+    record.count = count;
+    std::strncpy(record.name, name ? name : "", JOURNAL_NAME_LENGTH - 1);
+    record.name[JOURNAL_NAME_LENGTH - 1] = '\0';
+
+    // Published last, so a reader of the live file never sees half a record
+    std::atomic_ref<uint32_t>(record.sequence).store(sequence++, std::memory_order_release);
+
+    next++;
+    appended++;
+}
@@ -0,0 +1,128 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/journal.h
+DESCRIPTION: Memory-mapped journal of engine events
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <mutex>
+#include <atomic>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define JOURNAL_MAGIC 0x4C4A4B44
+#define JOURNAL_VERSION 1
+
+// Length of the name carried by a record, including the null terminator.
+// Longer names are truncated.
+#define JOURNAL_NAME_LENGTH 36
+
+
+namespace Records {
+    // Records carry an `Events::Type`, or one of these journal-only types
+    enum Type {
+        // `value` is the wall time of the sweep in microseconds and `count`
+        // the amount of processes it matched
+        SWEEP = 64,
+    };
+}
+
+// Fixed-size record, 64 bytes so records never straddle a cache line. Also
+// read by journal.py, so the layout must not change without bumping
+// `JOURNAL_VERSION`.
+struct JournalRecord {
+    // Milliseconds since the Unix epoch
+    int64_t timestamp;
+    // Increases by one per record, carrying on across rotations and from
+    // the last record of a reopened file. Written last, so a
+    // record with a sequence of 0 is unused or was never finished.
+    uint32_t sequence;
+    uint16_t type;
+    uint16_t reserved;
+    uint32_t pid;
+    // `Events::TERMINATED`: milliseconds from request to exit
+    uint32_t value;
+    // `Events::TERMINATED` and `Events::FAILED`: attempts taken
+    uint32_t count;
+    char name[JOURNAL_NAME_LENGTH];
+};
+
+// Occupies the first record's worth of the file
+struct JournalHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t reserved;
+    uint64_t capacity;
+    char padding[40];
+};
+
+static_assert(sizeof(JournalRecord) == 64, "journal records must stay 64 bytes");
+static_assert(sizeof(JournalHeader) == sizeof(JournalRecord), "the header must fill one record");
+
+// Append-only journal in a preallocated, memory-mapped file. Once the file
+// is full it is rotated to `<path>.1`, `<path>.2` and so on, and a fresh one
+// is started.
+class Journal {
+    std::mutex mutex;
+
+    std::string path;
+    std::size_t capacity = 0;
+    int files = 0;
+
+    JournalHeader* header = nullptr;
+    JournalRecord* records = nullptr;
+    std::size_t next = 0;
+    uint32_t sequence = 1;
+    // Set when the file on disk has another layout or capacity
+    bool stale = false;
+
+    std::atomic<uint64_t> appended{0};
+
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int file = -1;
+#endif
+
+    bool map();
+    void unmap();
+    void rotate();
+
+public:
+    ~Journal();
+
+    bool open(const std::string& path, std::size_t capacity, int files);
+    void close();
+    bool is_open();
+
+    void append(int type, uint32_t pid, const char* name, uint32_t value = 0, uint32_t count = 0);
+
+    uint64_t get_appended() const { return appended; }
+};
+
+#endif // JOURNAL_H
@@ -0,0 +1,219 @@
+"""Query the DieKnow event journal.
+
+Reads the journal files written by the engine (see `journal_path` in
+settings.conf) without loading the DLL, so it also works on a copy of the
+files taken from another computer.
+"""
+
+import argparse
+import datetime
+import glob
+import mmap
+import os
+import struct
+import sys
+
+
+JOURNAL_MAGIC = 0x4C4A4B44
+JOURNAL_VERSION = 1
+
+# Mirrors JournalHeader and JournalRecord in journal.h
+HEADER = struct.Struct("<IIIIQ40x")
+RECORD = struct.Struct("<qIHHIII36s")
+
+TYPE_NAMES = {
+    0: "discovered",
+    1: "matched",
+    2: "terminated",
+    3: "failed",
+    4: "settings",
+    5: "power",
+    64: "sweep",
+}
+TYPE_CODES = {name: code for code, name in TYPE_NAMES.items()}
+
+
+def journal_files(path):
+    """List the journal at `path` and its rotated files, oldest first."""
+
+    rotated = [name for name in glob.glob(glob.escape(path) + ".*")
+               if name.rsplit(".", 1)[1].isdigit()]
+    rotated.sort(key=lambda name: int(name.rsplit(".", 1)[1]), reverse=True)
+
+    return rotated + ([path] if os.path.exists(path) else [])
+
+
+def read_records(path):
+    """Yield the finished records of one journal file as tuples of
+    (timestamp, sequence, type, pid, value, count, name)."""
+
+    with open(path, "rb") as file:
+        if os.fstat(file.fileno()).st_size < RECORD.size:
+            return
+
+        with mmap.mmap(file.fileno(), 0, access=mmap.ACCESS_READ) as view:
+            magic, version, record_size, _, capacity = HEADER.unpack_from(view, 0)
+
+            if ((magic != JOURNAL_MAGIC) or (version != JOURNAL_VERSION) or
+                    (record_size != RECORD.size)):
+                print(f"Skipping {path}: not a journal this tool can read.",
+                      file=sys.stderr)
+                return
+
+            end = min(len(view), (capacity + 1) * RECORD.size)
+
+            for timestamp, sequence, kind, _, pid, value, count, name in \
+                    RECORD.iter_unpack(view[RECORD.size:end]):
+                # Records are filled in order; the first unused one ends it
+                if sequence == 0:
+                    break
+
+                name = name.split(b"\0", 1)[0].decode(errors="replace")
+                yield (timestamp, sequence, kind, pid, value, count, name)
+
+
+def parse_time(text):
+    """Parse "HH:MM" (today) or an ISO date and time into milliseconds since
+    the Unix epoch."""
+
+    try:
+        moment = datetime.datetime.fromisoformat(text)
+    except ValueError:
+        clock = datetime.datetime.strptime(text, "%H:%M").time()
+        moment = datetime.datetime.combine(datetime.date.today(), clock)
+
+    return int(moment.timestamp() * 1000)
+
+
+def format_time(timestamp):
+    return datetime.datetime.fromtimestamp(timestamp / 1000).strftime(
+        "%Y-%m-%d %H:%M:%S")
+
+
+def percentile(values, fraction):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(len(ordered) * fraction))]
+
+
+def summarize(records):
+    """Print kills, failures and latency per target, and the sweep cost."""
+
+    targets = {}
+    sweeps = []
+    first = last = None
+
+    for timestamp, _, kind, _, value, count, name in records:
+        first = timestamp if first is None else first
+        last = timestamp
+
+        if kind == TYPE_CODES["sweep"]:
+            sweeps.append((value, count))
+            continue
+
+        target = targets.setdefault(
+            name, {"matched": 0, "terminated": 0, "failed": 0, "latency": []})
+
+        if kind == TYPE_CODES["matched"]:
+            target["matched"] += 1
+        elif kind == TYPE_CODES["terminated"]:
+            target["terminated"] += 1
+            target["latency"].append(value)
+        elif kind == TYPE_CODES["failed"]:
+            target["failed"] += 1
+
+    if first is None:
+        print("No records.")
+        return
+
+    print(f"From {format_time(first)} to {format_time(last)}\n")
+
+    print(f"{'target':<36} {'matched':>8} {'killed':>8} {'failed':>8} "
+          f"{'avg ms':>8} {'p95 ms':>8}")
+
+    for name, target in sorted(targets.items(),
+                               key=lambda item: -item[1]["terminated"]):
+        if not (target["matched"] or target["terminated"] or target["failed"]):
+            continue
+
+        latency = target["latency"]
+        average = f"{sum(latency) / len(latency):.0f}" if latency else "-"
+        high = f"{percentile(latency, 0.95)}" if latency else "-"
+
+        print(f"{name:<36} {target['matched']:>8} {target['terminated']:>8} "
+              f"{target['failed']:>8} {average:>8} {high:>8}")
+
+    if sweeps:
+        durations = [value / 1000 for value, _ in sweeps]
+        print(f"\n{len(sweeps)} sweeps, {sum(durations) / len(durations):.2f} ms "
+              f"average, {percentile(durations, 0.95):.2f} ms p95, "
+              f"{sum(count for _, count in sweeps)} matches")
+
+
+def main():
+    """Main starting point."""
+
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("files", nargs="*",
+                        help="journal files; defaults to ./journal.dkj and "
+                             "its rotated files")
+    parser.add_argument("--since", help="only records from this time on, "
+                                        "as HH:MM or an ISO date and time")
+    parser.add_argument("--until", help="only records before this time")
+    parser.add_argument("--target", help="only records whose name contains "
+                                         "this, ignoring case")
+    parser.add_argument("--type", choices=sorted(TYPE_CODES),
+                        action="append", help="only records of this type; "
+                                              "may be repeated")
+    parser.add_argument("--summary", action="store_true",
+                        help="aggregate per target instead of listing")
+    arguments = parser.parse_args()
+
+    files = arguments.files or journal_files("./journal.dkj")
+    if not files:
+        print("No journal found.", file=sys.stderr)
+        return 1
+
+    since = parse_time(arguments.since) if arguments.since else None
+    until = parse_time(arguments.until) if arguments.until else None
+    target = arguments.target.lower() if arguments.target else None
+    kinds = {TYPE_CODES[name] for name in arguments.type or ()}
+
+    def selected():
+        for path in files:
+            for record in read_records(path):
+                timestamp, _, kind, _, _, _, name = record
+
+                if (since is not None) and (timestamp < since):
+                    continue
+                if (until is not None) and (timestamp >= until):
+                    continue
+                if kinds and (kind not in kinds):
+                    continue
+                # Sweeps carry no name, but are kept for the summary
+                if target and (target not in name.lower()) and \
+                        (kind != TYPE_CODES["sweep"] or not arguments.summary):
+                    continue
+
+                yield record
+
+    if arguments.summary:
+        summarize(selected())
+        return 0
+
+    for timestamp, _, kind, pid, value, count, name in selected():
+        line = f"[{format_time(timestamp)}] {TYPE_NAMES.get(kind, kind):<10}"
+
+        if kind == TYPE_CODES["sweep"]:
+            line += f" {value / 1000:.2f} ms, {count} matched"
+        else:
+            line += f" {name} ({pid})"
+            if kind == TYPE_CODES["terminated"]:
+                line += f" after {value} ms, {count} attempt(s)"
+
+        print(line)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
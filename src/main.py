@@ -8,6 +8,15 @@ import dieknow
 
 faulthandler.enable()
 
+EVENT_NAMES = {
+    dieknow.TARGET_DISCOVERED: "Discovered",
+    dieknow.PROCESS_MATCHED: "Matched",
+    dieknow.TERMINATED: "Terminated",
+    dieknow.FAILED: "Failed",
+    dieknow.SETTINGS_RELOADED: "Settings reloaded",
+    dieknow.POWER_CHANGED: "Power source changed to",
+}
+
 
 def main():
     """Main starting point."""
@@ -45,6 +54,22 @@ def main():
                 killed = dieknow.get_killed_count()
                 print(f"Executables killed: {killed}")
 
+            case "events":
+                for event in dieknow.drain_events():
+                    print(f"[{event.timestamp}] {EVENT_NAMES[event.type]} "
+                          f"{event.name.decode()} (PID {event.pid})")
+
+            case "roots":
+                print(dieknow.get_monitored_roots().decode(), end="")
+
+            case _ if user_input.startswith(("add ", "remove ")):
+                command, folder = user_input.split(maxsplit=1)
+                if command == "add":
+                    changed = dieknow.add_monitored_root(folder.encode())
+                else:
+                    changed = dieknow.remove_monitored_root(folder.encode())
+                print("Done." if changed else "Nothing changed.")
+
             case "exit":
                 if dieknow.is_running:
                     dieknow.stop_monitoring()
@@ -0,0 +1,240 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/metrics.cpp
+DESCRIPTION: Prometheus metrics exporter
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "metrics.h"
+#include "pipe.h"
+
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+const double Histogram::bounds[METRICS_BUCKETS] = {
+    0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0
+};
+
+void Histogram::observe(double seconds) {
+    /*
+    Record one observation. Only a single thread may observe, but any thread
+    may read at the same time.
+    */
+
+    if (!(seconds >= 0.0)) seconds = 0.0;
+
+    int bucket = 0;
+    while ((bucket < METRICS_BUCKETS) && (seconds > bounds[bucket])) bucket++;
+
+    counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(static_cast<uint64_t>(std::llround(seconds * 1e6)), std::memory_order_relaxed);
+}
+
+void MetricsWriter::header(const char* name, const char* help, const char* type) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+void MetricsWriter::sample(const char* name, const char* suffix, const char* labels, double value) {
+    // Formatted on the stack so only `out` ever grows
+    char number[32];
+    std::snprintf(number, sizeof(number), "%.17g", value);
+
+    out += name;
+    out += suffix;
+    out += labels;
+    out += ' ';
+    out += number;
+    out += '\n';
+}
+
+void MetricsWriter::counter(const char* name, const char* help, double value) {
+    header(name, help, "counter");
+    sample(name, "", "", value);
+}
+
+void MetricsWriter::gauge(const char* name, const char* help, double value) {
+    header(name, help, "gauge");
+    sample(name, "", "", value);
+}
+
+void MetricsWriter::histogram(const char* name, const char* help, const Histogram& histogram) {
+    header(name, help, "histogram");
+    series(name, "", histogram);
+}
+
+void MetricsWriter::family(const char* name, const char* help, const char* type) {
+    header(name, help, type);
+}
+
+void MetricsWriter::series(const char* name, const char* labels, double value) {
+    char braced[METRICS_LABELS_LENGTH];
+    std::snprintf(braced, sizeof(braced), "{%s}", labels);
+
+    sample(name, "", braced, value);
+}
+
+void MetricsWriter::series(const char* name, const char* labels, const Histogram& histogram) {
+    /*
+    Write a histogram as cumulative `_bucket` samples followed by `_sum` and
+    `_count`, each with `labels` (which may be empty).
+
+    The count is the +Inf bucket itself, so the two always agree even while
+    the writer is observing.
+    */
+
+    char braced[METRICS_LABELS_LENGTH];
+    const char* separator = labels[0] ? "," : "";
+    uint64_t cumulative = 0;
+
+    for (int i = 0; i < METRICS_BUCKETS; i++) {
+        cumulative += histogram.get_count(i);
+
+        std::snprintf(braced, sizeof(braced), "{%s%sle=\"%g\"}", labels, separator, Histogram::bounds[i]);
+        sample(name, "_bucket", braced, static_cast<double>(cumulative));
+    }
+
+    cumulative += histogram.get_count(METRICS_BUCKETS);
+
+    std::snprintf(braced, sizeof(braced), "{%s%sle=\"+Inf\"}", labels, separator);
+    sample(name, "_bucket", braced, static_cast<double>(cumulative));
+
+    std::snprintf(braced, sizeof(braced), labels[0] ? "{%s}" : "%s", labels);
+    sample(name, "_sum", braced, histogram.get_sum());
+    sample(name, "_count", braced, static_cast<double>(cumulative));
+}
+
+bool write_atomically(const std::string& path, const std::string& temporary, const std::string& text) {
+    /*
+    Replace the file at `path` with `text`, so a reader only ever sees the
+    old or the new contents in full.
+
+    The text is written to `temporary` first, which must be on the same
+    volume, and then renamed over `path`.
+    */
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(temporary.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    DWORD written = 0;
+    bool complete = WriteFile(file, text.data(), static_cast<DWORD>(text.size()), &written, nullptr) &&
+                    (written == text.size());
+    CloseHandle(file);
+
+    return complete && MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+    int file = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (file < 0) return false;
+
+    bool complete = true;
+    for (std::size_t done = 0; done < text.size();) {
+        ssize_t amount = ::write(file, text.data() + done, text.size() - done);
+        if (amount <= 0) {
+            complete = false;
+            break;
+        }
+        done += static_cast<std::size_t>(amount);
+    }
+    close(file);
+
+    return complete && (rename(temporary.c_str(), path.c_str()) == 0);
+#endif
+}
+
+MetricsExporter::MetricsExporter(std::function<void(MetricsWriter&)> collect)
+    : collect(std::move(collect)) {}
+
+void MetricsExporter::render(std::string& out) {
+    /*
+    Replace `out` with the current metrics. Keeping `out` around between
+    calls keeps its capacity, so steady-state renders don't allocate.
+    */
+
+    out.clear();
+
+    MetricsWriter writer(out);
+    collect(writer);
+
+    renders++;
+}
+
+void MetricsExporter::serve(std::string name) {
+    // The pipe renders into a buffer of its own, so scrapes of the pipe and
+    // writes of the file never share one
+    StatusPipe pipe(name);
+
+    while (pipe.serve([this](std::string& out) { render(out); })) {}
+
+    std::fprintf(stderr, "Unable to create the metrics endpoint %s!\n", pipe_path(name).c_str());
+    serving = false;
+}
+
+void MetricsExporter::write(std::string path, int period) {
+    std::string temporary = path + ".tmp";
+
+    std::string text;
+    text.reserve(8192);
+
+    while (true) {
+        render(text);
+
+        if (!write_atomically(path, temporary, text)) {
+            std::fprintf(stderr, "Unable to write the metrics file %s!\n", path.c_str());
+        }
+
+        std::this_thread::sleep_for(std::chrono::seconds(period));
+    }
+}
+
+void MetricsExporter::start(const std::string& pipe, const std::string& file, int period) {
+    /*
+    Start exporting metrics on their own threads, never the monitor's.
+
+    If `pipe` isn't empty, a thread answers each connection to that endpoint
+    (see `pipe_path()`) with freshly rendered metrics, blocking in the kernel
+    in between. If `file` isn't empty, a thread rewrites it atomically every
+    `period` seconds. Each runs for the rest of the process, so calling this
+    again does nothing for an exporter that is already running.
+    */
+
+    if (!pipe.empty() && !serving.exchange(true)) {
+        std::thread(&MetricsExporter::serve, this, pipe).detach();
+    }
+
+    if (!file.empty() && !writing.exchange(true)) {
+        std::thread(&MetricsExporter::write, this, file, std::max(1, period)).detach();
+    }
+}
@@ -0,0 +1,102 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/metrics.h
+DESCRIPTION: Prometheus metrics exporter
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cstdint>
+#include <string>
+#include <atomic>
+#include <functional>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Upper bounds of the histogram buckets, in seconds, not counting +Inf
+#define METRICS_BUCKETS 13
+
+// Length of the labels of a sample, braces included, which fits a target name
+#define METRICS_LABELS_LENGTH 320
+
+
+// Latency histogram with exactly one writer and any amount of readers. Neither
+// side locks or allocates.
+class Histogram {
+    // The last bucket is +Inf. Counts are per bucket, not cumulative.
+    std::atomic<uint64_t> counts[METRICS_BUCKETS + 1] = {};
+    // Sum of every observation, in microseconds
+    std::atomic<uint64_t> sum{0};
+
+public:
+    static const double bounds[METRICS_BUCKETS];
+
+    void observe(double seconds);
+
+    uint64_t get_count(int bucket) const { return counts[bucket].load(std::memory_order_relaxed); }
+    double get_sum() const { return sum.load(std::memory_order_relaxed) / 1e6; }
+};
+
+// Appends metrics in the Prometheus text exposition format to a buffer. Once
+// the buffer has grown to fit, rendering doesn't allocate.
+class MetricsWriter {
+    std::string& out;
+
+    void header(const char* name, const char* help, const char* type);
+    void sample(const char* name, const char* suffix, const char* labels, double value);
+
+public:
+    explicit MetricsWriter(std::string& out) : out(out) {}
+
+    void counter(const char* name, const char* help, double value);
+    void gauge(const char* name, const char* help, double value);
+    void histogram(const char* name, const char* help, const Histogram& histogram);
+
+    // A metric with one series per set of labels (e.g. `target="x"`): the
+    // family is written once, then each of its series
+    void family(const char* name, const char* help, const char* type);
+    void series(const char* name, const char* labels, double value);
+    void series(const char* name, const char* labels, const Histogram& histogram);
+};
+
+bool write_atomically(const std::string& path, const std::string& temporary, const std::string& text);
+
+class MetricsExporter {
+    std::function<void(MetricsWriter&)> collect;
+
+    std::atomic<bool> serving{false};
+    std::atomic<bool> writing{false};
+    std::atomic<uint64_t> renders{0};
+
+    void serve(std::string name);
+    void write(std::string path, int period);
+
+public:
+    explicit MetricsExporter(std::function<void(MetricsWriter&)> collect);
+
+    void start(const std::string& pipe, const std::string& file, int period);
+    void render(std::string& out);
+
+    uint64_t get_renders() const { return renders; }
+};
+
+#endif // METRICS_H
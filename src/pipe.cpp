@@ -0,0 +1,182 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/pipe.cpp
+DESCRIPTION: Local status endpoint over a named pipe or Unix socket
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "pipe.h"
+
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+
+std::string pipe_path(const std::string& name) {
+    /*
+    Retrieve where the endpoint called `name` lives: a named pipe on Windows,
+    or a Unix socket in /tmp elsewhere.
+    */
+
+#ifdef _WIN32
+    return "\\\\.\\pipe\\" + name;
+#else
+    return "/tmp/" + name + ".sock";
+#endif
+}
+
+bool read_pipe(const std::string& name, std::string& text) {
+    /*
+    Connect to the endpoint called `name` and read everything it sends.
+    */
+
+    text.clear();
+    char buffer[4096];
+
+#ifdef _WIN32
+    std::string path = pipe_path(name);
+
+    if (!WaitNamedPipeA(path.c_str(), 2000)) return false;
+
+    HANDLE pipe = CreateFileA(path.c_str(), GENERIC_READ, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (pipe == INVALID_HANDLE_VALUE) return false;
+
+    DWORD amount = 0;
+    while (ReadFile(pipe, buffer, sizeof(buffer), &amount, nullptr) && (amount > 0)) {
+        text.append(buffer, amount);
+    }
+
+    CloseHandle(pipe);
+#else
+    int client = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (client < 0) return false;
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, pipe_path(name).c_str(), sizeof(address.sun_path) - 1);
+
+    if (connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(client);
+        return false;
+    }
+
+    ssize_t amount;
+    while ((amount = read(client, buffer, sizeof(buffer))) > 0) {
+        text.append(buffer, static_cast<std::size_t>(amount));
+    }
+
+    close(client);
+#endif
+
+    return true;
+}
+
+StatusPipe::StatusPipe(const std::string& name) : path(pipe_path(name)) {
+#ifndef _WIN32
+    listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0) return;
+
+    // A socket left behind by a previous run would make bind() fail
+    unlink(path.c_str());
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    if ((bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) ||
+        (listen(listener, 4) != 0)) {
+        close(listener);
+        listener = -1;
+    }
+#endif
+}
+
+StatusPipe::~StatusPipe() {
+#ifndef _WIN32
+    if (listener >= 0) {
+        close(listener);
+        unlink(path.c_str());
+    }
+#endif
+}
+
+bool StatusPipe::serve(const std::function<std::string()>& render) {
+    /*
+    Wait for one client, send it the text from `render()` and disconnect.
+
+    The wait blocks in the kernel, so a thread serving status costs no CPU
+    between queries. The text is only rendered once a client has connected.
+    Returns false if the endpoint can't be created.
+    */
+
+    return serve([&render](std::string& out) { out = render(); });
+}
+
+bool StatusPipe::serve(const std::function<void(std::string&)>& render) {
+    /*
+    Like the above, but `render()` fills a buffer that is kept between
+    clients, so serving doesn't allocate once the buffer has grown to fit.
+    */
+
+#ifdef _WIN32
+    HANDLE pipe = CreateNamedPipeA(
+        path.c_str(),
+        PIPE_ACCESS_OUTBOUND,
+        PIPE_TYPE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+        PIPE_UNLIMITED_INSTANCES,
+        4096, 0, 0, nullptr
+    );
+    if (pipe == INVALID_HANDLE_VALUE) return false;
+
+    bool connected = ConnectNamedPipe(pipe, nullptr) || (GetLastError() == ERROR_PIPE_CONNECTED);
+
+    if (connected) {
+        render(text);
+
+        DWORD written = 0;
+        WriteFile(pipe, text.data(), static_cast<DWORD>(text.size()), &written, nullptr);
+        FlushFileBuffers(pipe);
+        DisconnectNamedPipe(pipe);
+    }
+
+    CloseHandle(pipe);
+    return true;
+#else
+    if (listener < 0) return false;
+
+    int client = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client < 0) return true;
+
+    render(text);
+
+    for (std::size_t sent = 0; sent < text.size();) {
+        // A client that hangs up mid-reply must not raise SIGPIPE, which
+        // would end the whole process
+        ssize_t amount = send(client, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+        if (amount <= 0) break;
+        sent += static_cast<std::size_t>(amount);
+    }
+
+    close(client);
+    return true;
+#endif
+}
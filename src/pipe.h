@@ -0,0 +1,55 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/pipe.h
+DESCRIPTION: Local status endpoint over a named pipe or Unix socket
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef PIPE_H
+#define PIPE_H
+
+#include <string>
+#include <functional>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+
+std::string pipe_path(const std::string& name);
+
+bool read_pipe(const std::string& name, std::string& text);
+
+class StatusPipe {
+    std::string path;
+    // Reused between clients by the buffer-filling `serve()`
+    std::string text;
+
+#ifndef _WIN32
+    int listener = -1;
+#endif
+
+public:
+    explicit StatusPipe(const std::string& name);
+    ~StatusPipe();
+
+    bool serve(const std::function<std::string()>& render);
+    bool serve(const std::function<void(std::string&)>& render);
+};
+
+#endif // PIPE_H
@@ -0,0 +1,190 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/power.cpp
+DESCRIPTION: Power source tracking for the battery profile
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "power.h"
+
+#include <cstdio>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+
+PowerMonitor::PowerMonitor(const std::string& supplies) : supplies(supplies) {}
+
+#ifndef _WIN32
+// Raw record returned by getdents64, which glibc does not declare
+struct SupplyDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+static bool read_type(int directory, const char* name, char* type, std::size_t size) {
+    // Read a supply's `type` file into `type`, without its trailing newline
+    char path[POWER_SUPPLY_PATH_LENGTH];
+    std::snprintf(path, sizeof(path), "%s/type", name);
+
+    int file = openat(directory, path, O_RDONLY | O_CLOEXEC);
+    if (file < 0) return false;
+
+    ssize_t length = read(file, type, size - 1);
+    close(file);
+
+    if (length <= 0) return false;
+    while ((length > 0) && ((type[length - 1] == '\n') || (type[length - 1] == '\r'))) length--;
+    type[length] = '\0';
+
+    return true;
+}
+
+void PowerMonitor::list() {
+    /*
+    List the power supplies and remember which files say whether external
+    power is connected. Caller must hold `mutex`.
+
+    This runs on the sweep path, so the directory is read with `getdents64`
+    into the stack and the paths are kept in fixed buffers; nothing is
+    allocated.
+    */
+
+    online_count = 0;
+    has_battery = false;
+
+    int directory = open(supplies.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (directory >= 0) {
+        alignas(8) char entries[4096];
+
+        while (true) {
+            long amount = syscall(SYS_getdents64, directory, entries, sizeof(entries));
+            if (amount <= 0) break;
+
+            for (long position = 0; position < amount;) {
+                const SupplyDirent64* entry = reinterpret_cast<const SupplyDirent64*>(entries + position);
+                position += entry->d_reclen;
+
+                const char* name = entry->d_name;
+                if (name[0] == '.') continue;
+
+                char type[32];
+                if (!read_type(directory, name, type, sizeof(type))) continue;
+
+                if (std::strcmp(type, "Battery") == 0) {
+                    has_battery = true;
+                }
+                else if (((std::strcmp(type, "Mains") == 0) || (std::strcmp(type, "USB") == 0) ||
+                          (std::strcmp(type, "USB_C") == 0)) && (online_count < POWER_SUPPLY_COUNT)) {
+                    int length = std::snprintf(online[online_count], POWER_SUPPLY_PATH_LENGTH,
+                                               "%s/%s/online", supplies.c_str(), name);
+
+                    // A truncated path would read the wrong file
+                    if ((length > 0) && (length < POWER_SUPPLY_PATH_LENGTH)) online_count++;
+                }
+            }
+        }
+
+        close(directory);
+    }
+
+    listed = std::chrono::steady_clock::now();
+    ever_listed = true;
+}
+
+static bool read_flag(const char* path) {
+    // A plain read into the stack, as this runs every sweep
+    int file = open(path, O_RDONLY | O_CLOEXEC);
+    if (file < 0) return false;
+
+    char value = '0';
+    bool read_any = read(file, &value, 1) == 1;
+    close(file);
+
+    return read_any && (value == '1');
+}
+#endif
+
+bool PowerMonitor::query() {
+    /*
+    Check whether the machine is running on battery right now.
+
+    Machines without a battery, or whose power source can't be read, count
+    as being on AC power. On Linux the supplies themselves are only listed
+    every `POWER_SUPPLY_RESCAN` seconds; in between, only their `online`
+    files are read.
+    */
+
+#ifdef _WIN32
+    (void)supplies;
+
+    SYSTEM_POWER_STATUS status = {};
+    if (!GetSystemPowerStatus(&status)) return false;
+
+    // 0 is offline, 1 online and 255 unknown
+    return status.ACLineStatus == 0;
+#else
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!ever_listed ||
+        (std::chrono::steady_clock::now() - listed >= std::chrono::seconds(POWER_SUPPLY_RESCAN))) {
+        list();
+    }
+
+    if (!has_battery) return false;
+
+    for (int i = 0; i < online_count; i++) {
+        if (read_flag(online[i])) return false;
+    }
+
+    return true;
+#endif
+}
+
+bool PowerMonitor::update() {
+    /*
+    Read the power source again.
+
+    Cheap enough to call every sweep, and only ever called by the monitor
+    thread. Other threads (the GUI on `WM_POWERBROADCAST`) call
+    `request_recheck` instead, which the monitor picks up on its next tick.
+    Returns true if the machine switched between battery and AC since the
+    last update, which counts as a transition.
+    */
+
+    recheck = false;
+
+    bool now = query();
+    bool previous = battery.exchange(now);
+
+    if (!known.exchange(true)) return false;
+    if (previous == now) return false;
+
+    transitions++;
+    return true;
+}
@@ -0,0 +1,114 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/power.h
+DESCRIPTION: Power source tracking for the battery profile
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+#include "settings.h"
+
+// Where Linux lists its power supplies
+#define POWER_SUPPLY_PATH "/sys/class/power_supply"
+
+// How often Linux lists its power supplies again, in seconds, to notice
+// supplies that were added or removed
+#define POWER_SUPPLY_RESCAN 60
+
+// Most external supplies remembered by a listing, and the longest path to
+// one of their `online` files
+#define POWER_SUPPLY_COUNT 8
+#define POWER_SUPPLY_PATH_LENGTH 256
+
+
+class PowerMonitor {
+    std::string supplies;
+
+#ifndef _WIN32
+    // The `online` file of every external supply, and whether there is a
+    // battery at all, as of the last listing. Fixed buffers, since the
+    // listing is redone on the sweep path.
+    std::mutex mutex;
+    char online[POWER_SUPPLY_COUNT][POWER_SUPPLY_PATH_LENGTH] = {};
+    int online_count = 0;
+    bool has_battery = false;
+    std::chrono::steady_clock::time_point listed;
+    bool ever_listed = false;
+
+    void list();
+#endif
+
+    // Updated by the monitor thread, read from any
+    std::atomic<bool> battery{false};
+    std::atomic<bool> known{false};
+    std::atomic<int> transitions{0};
+
+    // Set from any thread when the power source may have changed
+    std::atomic<bool> recheck{false};
+
+    bool query();
+
+public:
+    explicit PowerMonitor(const std::string& supplies = POWER_SUPPLY_PATH);
+
+    bool update();
+
+    void request_recheck() { recheck = true; }
+    bool recheck_requested() const { return recheck; }
+
+    bool on_battery() const { return battery; }
+    int get_transitions() const { return transitions; }
+
+    template <typename T>
+    T get(const Settings& settings, std::string_view key, T default_value) const;
+};
+
+template <typename T>
+T PowerMonitor::get(const Settings& settings, std::string_view key, T default_value) const {
+    /*
+    Retrieve a setting for the current power source.
+
+    On battery, a `battery_` prefixed setting (e.g. `battery_interval`) wins
+    over the usual one, unless `battery_profile` is off.
+    */
+
+    T value = settings.get<T>(key, default_value);
+
+    if (battery && settings.get<bool>("battery_profile", true)) {
+        // Built on the stack, since this runs every sweep
+        char prefixed[64] = "battery_";
+        std::size_t length = std::min(key.size(), sizeof(prefixed) - 9);
+        std::memcpy(prefixed + 8, key.data(), length);
+
+        value = settings.get<T>(std::string_view(prefixed, 8 + length), value);
+    }
+
+    return value;
+}
+
+#endif // POWER_H
@@ -0,0 +1,415 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/process.cpp
+DESCRIPTION: Process enumeration backends
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "process.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <tlhelp32.h>
+#include <winternl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <dirent.h>
+#endif
+
+
+#ifdef _WIN32
+
+bool Toolhelp32Source::snapshot(std::vector<ProcessInfo>& processes) {
+    /*
+    Enumerate processes through a Toolhelp32 snapshot.
+
+    This copies the whole process table into a kernel section on every call
+    and walks it one `Process32Next()` at a time. It is kept as a fallback
+    and as the baseline for benchmarks.
+    */
+
+    processes.clear();
+
+    HANDLE hProcessSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (hProcessSnap == INVALID_HANDLE_VALUE) return false;
+
+    PROCESSENTRY32 pe32;
+    pe32.dwSize = sizeof(PROCESSENTRY32);
+
+    if (Process32First(hProcessSnap, &pe32)) {
+        do {
+            ProcessInfo& info = processes.emplace_back();
+            info.pid = pe32.th32ProcessID;
+            info.ppid = pe32.th32ParentProcessID;
+            info.create_time = 0;
+
+            std::strncpy(info.name, pe32.szExeFile, PROCESS_NAME_LENGTH - 1);
+            info.name[PROCESS_NAME_LENGTH - 1] = '\0';
+        } while (Process32Next(hProcessSnap, &pe32));
+    }
+
+    CloseHandle(hProcessSnap);
+    return true;
+}
+
+// Layout of SYSTEM_PROCESS_INFORMATION up to the fields we read. The SDK and
+// MinGW headers disagree on the reserved fields, so it is spelled out here.
+struct NtProcessEntry {
+    ULONG NextEntryOffset;
+    ULONG NumberOfThreads;
+    LARGE_INTEGER WorkingSetPrivateSize;
+    ULONG HardFaultCount;
+    ULONG NumberOfThreadsHighWatermark;
+    ULONGLONG CycleTime;
+    LARGE_INTEGER CreateTime;
+    LARGE_INTEGER UserTime;
+    LARGE_INTEGER KernelTime;
+    UNICODE_STRING ImageName;
+    LONG BasePriority;
+    HANDLE UniqueProcessId;
+    HANDLE InheritedFromUniqueProcessId;
+};
+
+#define SYSTEM_PROCESS_INFORMATION_CLASS 5
+#define STATUS_INFO_LENGTH_MISMATCH_CODE static_cast<LONG>(0xC0000004)
+
+NtQuerySource::NtQuerySource() {
+    query = reinterpret_cast<NtQuerySystemInformationFunction>(
+        GetProcAddress(GetModuleHandleW(L"ntdll.dll"), "NtQuerySystemInformation"));
+
+    // Large enough for a few hundred processes; grown on demand
+    buffer.resize(256 * 1024);
+}
+
+bool NtQuerySource::snapshot(std::vector<ProcessInfo>& processes) {
+    /*
+    Enumerate processes with a single `NtQuerySystemInformation()` call.
+
+    The whole process table is copied straight into a buffer that is reused
+    across sweeps, with no kernel section and no per-process calls. If the
+    buffer is too small it is grown to the size the kernel asks for, plus
+    headroom for processes started in between.
+    */
+
+    processes.clear();
+    if (!query) return false;
+
+    LONG status;
+    ULONG needed = 0;
+
+    while ((status = query(
+                SYSTEM_PROCESS_INFORMATION_CLASS,
+                buffer.data(),
+                static_cast<ULONG>(buffer.size()),
+                &needed)) == STATUS_INFO_LENGTH_MISMATCH_CODE) {
+        buffer.resize(needed + (64 * 1024));
+    }
+
+    if (status < 0) return false;
+
+    std::size_t offset = 0;
+
+    while (true) {
+        const NtProcessEntry* entry = reinterpret_cast<const NtProcessEntry*>(buffer.data() + offset);
+
+        ProcessInfo& info = processes.emplace_back();
+        info.pid = static_cast<uint32_t>(reinterpret_cast<ULONG_PTR>(entry->UniqueProcessId));
+        info.ppid = static_cast<uint32_t>(reinterpret_cast<ULONG_PTR>(entry->InheritedFromUniqueProcessId));
+        info.create_time = static_cast<uint64_t>(entry->CreateTime.QuadPart);
+
+        // Names are UTF-16 and not null-terminated; convert them to the same
+        // ANSI code page Toolhelp32 reports in
+        int length = 0;
+        if (entry->ImageName.Buffer) {
+            length = WideCharToMultiByte(
+                CP_ACP, 0,
+                entry->ImageName.Buffer,
+                entry->ImageName.Length / sizeof(WCHAR),
+                info.name, PROCESS_NAME_LENGTH - 1,
+                nullptr, nullptr
+            );
+        }
+        info.name[length] = '\0';
+
+        if (entry->NextEntryOffset == 0) break;
+        offset += entry->NextEntryOffset;
+    }
+
+    return true;
+}
+
+#else
+
+// Raw record returned by getdents64, which glibc does not declare
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+ProcfsSource::ProcfsSource() {
+    proc = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    buffer.resize(64 * 1024);
+}
+
+ProcfsSource::~ProcfsSource() {
+    if (proc >= 0) close(proc);
+}
+
+bool ProcfsSource::snapshot(std::vector<ProcessInfo>& processes) {
+    /*
+    Enumerate processes from /proc.
+
+    The /proc directory stays open and is rewound for every snapshot, and its
+    entries are read in large batches with `getdents64`. Each process costs a
+    single read of /proc/<pid>/stat, which carries the name (the same text as
+    /proc/<pid>/comm), the parent PID and the start time together.
+    */
+
+    processes.clear();
+    if (proc < 0) return false;
+
+    lseek(proc, 0, SEEK_SET);
+
+    while (true) {
+        long amount = syscall(SYS_getdents64, proc, buffer.data(), buffer.size());
+        if (amount <= 0) break;
+
+        for (long position = 0; position < amount;) {
+            const LinuxDirent64* entry = reinterpret_cast<const LinuxDirent64*>(buffer.data() + position);
+            position += entry->d_reclen;
+
+            // Only the numeric folders are processes
+            const char* name = entry->d_name;
+            if ((name[0] < '0') || (name[0] > '9')) continue;
+
+            char path[64];
+            std::snprintf(path, sizeof(path), "%s/stat", name);
+
+            int file = openat(proc, path, O_RDONLY | O_CLOEXEC);
+            if (file < 0) continue;
+
+            char stat[512];
+            ssize_t length = read(file, stat, sizeof(stat) - 1);
+            close(file);
+
+            if (length <= 0) continue;
+            stat[length] = '\0';
+
+            // The name is in parentheses and may itself contain spaces or
+            // parentheses, so everything after the last ')' is parsed
+            char* open_paren = std::strchr(stat, '(');
+            char* close_paren = std::strrchr(stat, ')');
+            if (!open_paren || !close_paren || (close_paren < open_paren)) continue;
+
+            ProcessInfo& info = processes.emplace_back();
+            info.pid = static_cast<uint32_t>(std::strtoul(stat, nullptr, 10));
+
+            std::size_t name_length = static_cast<std::size_t>(close_paren - open_paren - 1);
+            if (name_length > PROCESS_NAME_LENGTH - 1) name_length = PROCESS_NAME_LENGTH - 1;
+            std::memcpy(info.name, open_paren + 1, name_length);
+            info.name[name_length] = '\0';
+
+            // Fields after the name: state, ppid, ... with starttime the 20th
+            char* field = close_paren + 2;
+            unsigned long long values[20] = {};
+            int index = 0;
+
+            // Skip the state character
+            field = std::strchr(field, ' ');
+            while (field && (index < 20)) {
+                values[index++] = std::strtoull(field + 1, &field, 10);
+                if (*field != ' ') break;
+            }
+
+            info.ppid = static_cast<uint32_t>(values[0]);
+            info.create_time = values[18];
+        }
+    }
+
+    return true;
+}
+
+#endif
+
+// Deepest ancestry followed, which also guards against PID cycles
+#define PROCESS_TREE_DEPTH 64
+
+std::size_t ProcessTree::find(uint32_t pid) const {
+    // Index of `pid` in the snapshot, or `SIZE_MAX` if it isn't in it
+    auto it = std::lower_bound(index.begin(), index.end(), pid,
+                               [](const auto& entry, uint32_t value) { return entry.first < value; });
+
+    return ((it != index.end()) && (it->first == pid)) ? it->second : SIZE_MAX;
+}
+
+std::size_t ProcessTree::parent(const std::vector<ProcessInfo>& processes, std::size_t child) const {
+    /*
+    Find the index of a process' parent in the snapshot, or `SIZE_MAX` if the
+    parent has exited.
+
+    Windows reuses PIDs, so a "parent" created after its child is really an
+    unrelated process that inherited the PID and is ignored.
+    */
+
+    const ProcessInfo& process = processes[child];
+    if ((process.ppid == 0) || (process.ppid == process.pid)) return SIZE_MAX;
+
+    std::size_t found = find(process.ppid);
+    if (found == SIZE_MAX) return SIZE_MAX;
+
+    const ProcessInfo& candidate = processes[found];
+    if ((candidate.create_time != 0) && (process.create_time != 0) &&
+        (candidate.create_time > process.create_time)) {
+        return SIZE_MAX;
+    }
+
+    return found;
+}
+
+std::size_t ProcessTree::order(const std::vector<ProcessInfo>& processes, std::vector<std::size_t>& targets) {
+    /*
+    Reorder `targets` (indices into `processes`) from the roots of the process
+    tree downward.
+
+    Every target comes after all of its targeted ancestors, so a supervisor is
+    always terminated before the children it would otherwise relaunch. The
+    order is otherwise stable.
+
+    Returns how many targets the snapshot order would have terminated before
+    one of their targeted ancestors, which are the respawns this prevents.
+    */
+
+    // Most sweeps match nothing
+    if (targets.empty()) return 0;
+
+    index.clear();
+    matched.clear();
+    depths.clear();
+
+    for (std::size_t i = 0; i < processes.size(); i++) {
+        index.emplace_back(processes[i].pid, i);
+    }
+    for (std::size_t target : targets) {
+        matched.push_back(processes[target].pid);
+    }
+
+    std::sort(index.begin(), index.end());
+    std::sort(matched.begin(), matched.end());
+
+    std::size_t prevented = 0;
+
+    for (std::size_t target : targets) {
+        int depth = 0;
+        bool respawn = false;
+
+        std::size_t current = target;
+        while (depth < PROCESS_TREE_DEPTH) {
+            std::size_t ancestor = parent(processes, current);
+            if (ancestor == SIZE_MAX) break;
+
+            depth++;
+
+            // A targeted ancestor later in the snapshot would still be alive
+            // when this process is killed in snapshot order
+            if ((ancestor > target) &&
+                std::binary_search(matched.begin(), matched.end(), processes[ancestor].pid)) {
+                respawn = true;
+            }
+
+            current = ancestor;
+        }
+
+        if (respawn) prevented++;
+        depths.emplace_back(depth, target);
+    }
+
+    std::stable_sort(depths.begin(), depths.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    for (std::size_t i = 0; i < depths.size(); i++) {
+        targets[i] = depths[i].second;
+    }
+
+    return prevented;
+}
+
+bool ProcessSource::image(uint32_t pid, char* path, std::size_t size) {
+    /*
+    Look up the executable a process was started from, for matching renamed
+    copies by their contents. Every backend shares this; the snapshots
+    themselves only carry the name.
+    */
+
+    if (size == 0) return false;
+
+#ifdef _WIN32
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (!process) return false;
+
+    DWORD length = static_cast<DWORD>(size);
+    bool found = QueryFullProcessImageNameA(process, 0, path, &length) != FALSE;
+
+    CloseHandle(process);
+    return found;
+#else
+    char link[64];
+    std::snprintf(link, sizeof(link), "/proc/%u/exe", pid);
+
+    ssize_t length = readlink(link, path, size - 1);
+    if (length <= 0) return false;
+
+    path[length] = '\0';
+    return true;
+#endif
+}
+
+std::unique_ptr<ProcessSource> create_process_source(const std::string& backend) {
+    /*
+    Create a process enumeration backend by name.
+
+    On Windows, "toolhelp" selects the Toolhelp32 snapshot and anything else
+    selects `NtQuerySystemInformation()`. Elsewhere /proc is always used.
+    */
+
+#ifdef _WIN32
+    if (backend == "toolhelp") return std::make_unique<Toolhelp32Source>();
+    return std::make_unique<NtQuerySource>();
+#else
+    (void)backend;
+    return std::make_unique<ProcfsSource>();
+#endif
+}
+
+uint32_t current_process_id() {
+#ifdef _WIN32
+    return GetCurrentProcessId();
+#else
+    return static_cast<uint32_t>(getpid());
+#endif
+}
@@ -0,0 +1,123 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/process.h
+DESCRIPTION: Process enumeration backends
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef PROCESS_H
+#define PROCESS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Length of a process name, including the null terminator
+#define PROCESS_NAME_LENGTH 260
+// Length of the full path of a process's executable, including the null
+// terminator
+#define PROCESS_PATH_LENGTH 260
+
+
+struct ProcessInfo {
+    uint32_t pid;
+    uint32_t ppid;
+    // Backend-specific creation time, or 0 if the backend can't provide it.
+    // Together with the PID it identifies a process even if the PID is reused.
+    uint64_t create_time;
+    char name[PROCESS_NAME_LENGTH];
+};
+
+class ProcessSource {
+public:
+    virtual ~ProcessSource() = default;
+
+    // Replace `processes` with every running process. The vector's capacity is
+    // kept, so repeated snapshots don't allocate once warmed up.
+    virtual bool snapshot(std::vector<ProcessInfo>& processes) = 0;
+
+    // Copy the full path of a process's executable into `path`
+    virtual bool image(uint32_t pid, char* path, std::size_t size);
+
+    virtual const char* name() const = 0;
+};
+
+#ifdef _WIN32
+
+class Toolhelp32Source : public ProcessSource {
+public:
+    bool snapshot(std::vector<ProcessInfo>& processes) override;
+    const char* name() const override { return "toolhelp"; }
+};
+
+class NtQuerySource : public ProcessSource {
+    typedef LONG (WINAPI *NtQuerySystemInformationFunction)(ULONG, PVOID, ULONG, PULONG);
+
+    NtQuerySystemInformationFunction query = nullptr;
+    // Reused across sweeps and only ever grown
+    std::vector<unsigned char> buffer;
+
+public:
+    NtQuerySource();
+
+    bool snapshot(std::vector<ProcessInfo>& processes) override;
+    const char* name() const override { return "ntquery"; }
+};
+
+#else
+
+class ProcfsSource : public ProcessSource {
+    int proc = -1;
+    // Reused across sweeps for the raw directory entries
+    std::vector<char> buffer;
+
+public:
+    ProcfsSource();
+    ~ProcfsSource() override;
+
+    bool snapshot(std::vector<ProcessInfo>& processes) override;
+    const char* name() const override { return "procfs"; }
+};
+
+#endif
+
+class ProcessTree {
+    // Reused across sweeps, so ordering doesn't allocate once warmed up.
+    // Sorted vectors rather than hash maps, which would allocate a node per
+    // process every sweep.
+    std::vector<std::pair<uint32_t, std::size_t>> index;
+    std::vector<uint32_t> matched;
+    std::vector<std::pair<int, std::size_t>> depths;
+
+    std::size_t find(uint32_t pid) const;
+    std::size_t parent(const std::vector<ProcessInfo>& processes, std::size_t child) const;
+
+public:
+    std::size_t order(const std::vector<ProcessInfo>& processes, std::vector<std::size_t>& targets);
+};
+
+std::unique_ptr<ProcessSource> create_process_source(const std::string& backend);
+
+uint32_t current_process_id();
+
+#endif // PROCESS_H
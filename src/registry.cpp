@@ -0,0 +1,94 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/registry.cpp
+DESCRIPTION: Interned IDs and statistics of target executables
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "registry.h"
+
+#include <cctype>
+#include <cstring>
+#include <algorithm>
+
+
+static std::string_view lowercase(std::string_view text, char* buffer, std::size_t size) {
+    std::size_t length = 0;
+    for (; (length < text.size()) && (length < size); length++) {
+        buffer[length] = static_cast<char>(std::tolower(static_cast<unsigned char>(text[length])));
+    }
+    return std::string_view(buffer, length);
+}
+
+TargetRegistry::~TargetRegistry() {
+    for (auto& chunk : chunks) delete[] chunk.load(std::memory_order_relaxed);
+}
+
+uint32_t TargetRegistry::intern(std::string_view name, bool* created) {
+    /*
+    Retrieve the ID of a target, assigning the next one if the name hasn't
+    been seen before in any case. `created` is set to whether it was.
+
+    A new chunk of entries is allocated whenever the last one fills up.
+    Returns `TARGET_NONE` once every ID is taken.
+    */
+
+    if (created) *created = false;
+
+    char lowered[TARGET_NAME_LENGTH];
+    std::string_view key = lowercase(name, lowered, sizeof(lowered) - 1);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = ids.find(key);
+    if (it != ids.end()) return it->second;
+
+    uint32_t id = count.load(std::memory_order_relaxed);
+    if (id >= TARGET_CAPACITY) return TARGET_NONE;
+
+    std::atomic<TargetEntry*>& chunk = chunks[id / TARGET_CHUNK];
+    if (!chunk.load(std::memory_order_relaxed)) {
+        chunk.store(new TargetEntry[TARGET_CHUNK], std::memory_order_release);
+    }
+
+    TargetEntry& target = entry(id);
+    std::size_t length = std::min(name.size(), static_cast<std::size_t>(TARGET_NAME_LENGTH - 1));
+    std::memcpy(target.name, name.data(), length);
+    target.name[length] = '\0';
+
+    ids.emplace(std::string(key), id);
+    count.store(id + 1, std::memory_order_release);
+
+    if (created) *created = true;
+    return id;
+}
+
+uint32_t TargetRegistry::find(std::string_view name) const {
+    /*
+    Retrieve the ID of a target in any case, or `TARGET_NONE` if it was
+    never interned. Doesn't allocate.
+    */
+
+    char lowered[TARGET_NAME_LENGTH];
+    std::string_view key = lowercase(name, lowered, sizeof(lowered) - 1);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = ids.find(key);
+    return (it != ids.end()) ? it->second : TARGET_NONE;
+}
@@ -0,0 +1,97 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/registry.h
+DESCRIPTION: Interned IDs and statistics of target executables
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+
+#include "settings.h"
+#include "metrics.h"
+
+// Length of a target's name, including the null terminator
+#define TARGET_NAME_LENGTH 260
+
+// Entries are allocated in chunks of this many as targets are interned, and
+// there are at most `TARGET_CHUNKS` chunks. Names past that get no ID.
+#define TARGET_CHUNK 128
+#define TARGET_CHUNKS 1024
+#define TARGET_CAPACITY (TARGET_CHUNK * TARGET_CHUNKS)
+
+// ID of no target, such as a renamed copy only matched by its contents
+#define TARGET_NONE UINT32_MAX
+
+
+// Everything kept about one target, read by other threads without locking
+struct TargetEntry {
+    // As first discovered
+    char name[TARGET_NAME_LENGTH];
+
+    std::atomic<uint64_t> matched{0};
+    std::atomic<uint64_t> killed{0};
+    std::atomic<uint64_t> gave_up{0};
+    Histogram kill_latency;
+};
+
+// Interns the name of every discovered executable into a small integer ID,
+// case-insensitively and only once, so the engine, its statistics and the
+// GUI pass IDs around and index these dense arrays instead of hashing and
+// copying names. IDs are never reused or forgotten, and a chunk is never
+// moved once allocated, so IDs and references to entries stay valid.
+class TargetRegistry {
+    std::atomic<TargetEntry*> chunks[TARGET_CHUNKS] = {};
+    // Published after an entry is written, so readers only see whole entries
+    std::atomic<uint32_t> count{0};
+
+    TargetEntry& entry(uint32_t id) const {
+        return chunks[id / TARGET_CHUNK].load(std::memory_order_acquire)[id % TARGET_CHUNK];
+    }
+
+    // Lowercase name to ID, only for interning and finding
+    std::unordered_map<std::string, uint32_t, StringHash, std::equal_to<>> ids;
+    mutable std::mutex mutex;
+
+public:
+    TargetRegistry() = default;
+    ~TargetRegistry();
+
+    TargetRegistry(const TargetRegistry&) = delete;
+    TargetRegistry& operator=(const TargetRegistry&) = delete;
+
+    uint32_t intern(std::string_view name, bool* created = nullptr);
+    uint32_t find(std::string_view name) const;
+
+    uint32_t size() const { return count.load(std::memory_order_acquire); }
+
+    // Only valid for IDs below `size()`
+    const char* get_name(uint32_t id) const { return entry(id).name; }
+    TargetEntry& get(uint32_t id) { return entry(id); }
+    const TargetEntry& get(uint32_t id) const { return entry(id); }
+};
+
+#endif // REGISTRY_H
@@ -0,0 +1,115 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/roots.cpp
+DESCRIPTION: Registry of monitored folders
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "roots.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <cctype>
+
+
+static std::string normalize(const std::string& root) {
+    /*
+    Spell a folder path the same way however it was given, so one folder
+    can't be registered twice.
+    */
+
+    std::string result = std::filesystem::path(root).lexically_normal().string();
+
+    // "C:\DyKnow\" and "C:\DyKnow" are the same folder
+    while ((result.size() > 1) && ((result.back() == '\\') || (result.back() == '/'))) {
+        result.pop_back();
+    }
+
+    return result;
+}
+
+static bool same_root(const std::string& a, const std::string& b) {
+#ifdef _WIN32
+    // Windows paths are case-insensitive
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](char x, char y) {
+        return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+    });
+#else
+    return a == b;
+#endif
+}
+
+bool RootRegistry::add(const std::string& root) {
+    /*
+    Register a folder to be monitored. Returns false if it is empty or
+    already registered.
+    */
+
+    if (root.empty()) return false;
+
+    std::string path = normalize(root);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (const auto& existing : roots) {
+        if (same_root(existing, path)) return false;
+    }
+
+    roots.push_back(path);
+    version++;
+    return true;
+}
+
+bool RootRegistry::remove(const std::string& root) {
+    /*
+    Stop monitoring a folder. Returns false if it wasn't registered.
+    */
+
+    std::string path = normalize(root);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = std::find_if(roots.begin(), roots.end(), [&](const std::string& existing) {
+        return same_root(existing, path);
+    });
+    if (it == roots.end()) return false;
+
+    roots.erase(it);
+    version++;
+    return true;
+}
+
+bool RootRegistry::copy(std::vector<std::string>& out, uint64_t& seen) const {
+    /*
+    Copy the registered folders into `out` if they changed since version
+    `seen`, which is then updated. Returns whether anything was copied.
+    */
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (seen == version) return false;
+
+    out = roots;
+    seen = version;
+    return true;
+}
+
+std::size_t RootRegistry::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return roots.size();
+}
@@ -0,0 +1,47 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/roots.h
+DESCRIPTION: Registry of monitored folders
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef ROOTS_H
+#define ROOTS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+
+
+class RootRegistry {
+    std::vector<std::string> roots;
+    // Bumped on every change, so readers only copy the roots when needed
+    uint64_t version = 0;
+
+    mutable std::mutex mutex;
+
+public:
+    bool add(const std::string& root);
+    bool remove(const std::string& root);
+
+    bool copy(std::vector<std::string>& out, uint64_t& seen) const;
+    std::size_t size() const;
+};
+
+#endif // ROOTS_H
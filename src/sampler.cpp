@@ -0,0 +1,246 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/sampler.cpp
+DESCRIPTION: Background sampler of system and DieKnow resource usage
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "sampler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+
+static uint64_t ticks(const FILETIME& time) {
+    // 100 ns units
+    return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+}
+
+#else
+
+static bool read_file(const char* path, char* buffer, std::size_t size) {
+    // Small /proc files fit in one read into `buffer`, without a stream
+    int file = open(path, O_RDONLY | O_CLOEXEC);
+    if (file < 0) return false;
+
+    ssize_t length = ::read(file, buffer, size - 1);
+    close(file);
+
+    if (length <= 0) return false;
+    buffer[length] = '\0';
+    return true;
+}
+
+static uint64_t meminfo(const char* text, const char* key) {
+    // A value from /proc/meminfo in bytes, which lists them in kB
+    const char* line = std::strstr(text, key);
+    if (!line) return 0;
+    return std::strtoull(line + std::strlen(key), nullptr, 10) * 1024;
+}
+
+#endif
+
+bool ResourceSampler::read(ResourceSample& sample) {
+    /*
+    Take one sample of the counters. CPU usage is measured from the previous
+    sample, so the first one after starting reads as 0%.
+    */
+
+    uint64_t busy = 0;
+    uint64_t total = 0;
+    uint64_t own = 0;
+
+#ifdef _WIN32
+    FILETIME idle_time, kernel_time, user_time;
+    if (!GetSystemTimes(&idle_time, &kernel_time, &user_time)) return false;
+
+    // Kernel time includes the idle time
+    total = ticks(kernel_time) + ticks(user_time);
+    busy = total - ticks(idle_time);
+
+    FILETIME creation, exit, kernel, user;
+    if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        own = ticks(kernel) + ticks(user);
+    }
+
+    MEMORYSTATUSEX memory;
+    memory.dwLength = sizeof(memory);
+    if (!GlobalMemoryStatusEx(&memory)) return false;
+
+    sample.free_ram = memory.ullAvailPhys;
+    sample.total_ram = memory.ullTotalPhys;
+
+    PROCESS_MEMORY_COUNTERS counters;
+    sample.own_rss = GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))
+        ? counters.WorkingSetSize : 0;
+#else
+    char text[4096];
+
+    // Both in clock ticks: the first line of /proc/stat is every core together
+    if (!read_file("/proc/stat", text, sizeof(text))) return false;
+
+    unsigned long long fields[8] = {};
+    std::sscanf(text, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+                &fields[0], &fields[1], &fields[2], &fields[3],
+                &fields[4], &fields[5], &fields[6], &fields[7]);
+
+    for (unsigned long long field : fields) total += field;
+    // Idle and waiting for I/O
+    busy = total - fields[3] - fields[4];
+
+    if (read_file("/proc/self/stat", text, sizeof(text))) {
+        // The name may hold spaces, so count fields from after it
+        const char* end = std::strrchr(text, ')');
+        unsigned long long utime = 0, stime = 0;
+
+        if (end && (std::sscanf(end + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+                                &utime, &stime) == 2)) {
+            own = utime + stime;
+        }
+    }
+
+    if (!read_file("/proc/meminfo", text, sizeof(text))) return false;
+
+    sample.free_ram = meminfo(text, "MemAvailable:");
+    sample.total_ram = meminfo(text, "MemTotal:");
+
+    unsigned long long pages = 0;
+    sample.own_rss = (read_file("/proc/self/statm", text, sizeof(text)) &&
+                      (std::sscanf(text, "%*u %llu", &pages) == 1))
+        ? pages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) : 0;
+#endif
+
+    uint64_t elapsed = total - last_total;
+
+    if (primed && (elapsed > 0)) {
+        sample.system_cpu = 100.0 * static_cast<double>(busy - last_busy) / static_cast<double>(elapsed);
+        sample.own_cpu = 100.0 * static_cast<double>(own - last_own) / static_cast<double>(elapsed);
+    }
+    else {
+        sample.system_cpu = 0;
+        sample.own_cpu = 0;
+    }
+
+    last_busy = busy;
+    last_total = total;
+    last_own = own;
+    primed = true;
+
+    sample.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    return true;
+}
+
+bool ResourceSampler::sample() {
+    /*
+    Take a sample now and add it to the ring, overwriting the oldest once
+    it is full.
+    */
+
+    ResourceSample sample;
+    if (!read(sample)) return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    samples[head] = sample;
+    head = (head + 1) % SAMPLER_CAPACITY;
+    if (count < SAMPLER_CAPACITY) count++;
+
+    return true;
+}
+
+void ResourceSampler::run(int period) {
+    std::unique_lock<std::mutex> lock(waiting);
+
+    while (!stopping) {
+        lock.unlock();
+        sample();
+        lock.lock();
+
+        wake.wait_for(lock, std::chrono::milliseconds(period), [this]() { return stopping; });
+    }
+}
+
+void ResourceSampler::start(int period) {
+    /*
+    Sample every `period` milliseconds on a background thread until
+    `stop()`. Does nothing if it is already sampling or `period` isn't
+    positive.
+    */
+
+    if (thread.joinable() || (period <= 0)) return;
+
+    stopping = false;
+    thread = std::thread(&ResourceSampler::run, this, period);
+}
+
+void ResourceSampler::stop() {
+    if (!thread.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(waiting);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    thread.join();
+}
+
+ResourceSampler::~ResourceSampler() {
+    stop();
+}
+
+std::size_t ResourceSampler::copy(ResourceSample* out, std::size_t max) const {
+    /*
+    Copy up to `max` of the newest samples into `out`, oldest first, and
+    return how many were copied.
+    */
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::size_t amount = (count < max) ? count : max;
+    std::size_t first = (head + SAMPLER_CAPACITY - amount) % SAMPLER_CAPACITY;
+
+    for (std::size_t i = 0; i < amount; i++) {
+        out[i] = samples[(first + i) % SAMPLER_CAPACITY];
+    }
+
+    return amount;
+}
+
+bool ResourceSampler::latest(ResourceSample& sample) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (count == 0) return false;
+
+    sample = samples[(head + SAMPLER_CAPACITY - 1) % SAMPLER_CAPACITY];
+    return true;
+}
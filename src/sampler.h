@@ -0,0 +1,84 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/sampler.h
+DESCRIPTION: Background sampler of system and DieKnow resource usage
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Samples kept, oldest overwritten first
+#define SAMPLER_CAPACITY 120
+
+
+struct ResourceSample {
+    // Milliseconds since the Unix epoch
+    int64_t timestamp;
+    // Percentages of every core together, so DieKnow's share is on the same
+    // scale as the whole machine's
+    double system_cpu;
+    double own_cpu;
+    // Bytes
+    uint64_t free_ram;
+    uint64_t total_ram;
+    uint64_t own_rss;
+};
+
+// Samples the machine's CPU and memory and DieKnow's own on a thread of its
+// own into a fixed ring. A sample costs a few system calls and never
+// allocates, so it can run the whole time the GUI is open.
+class ResourceSampler {
+    ResourceSample samples[SAMPLER_CAPACITY];
+    std::size_t head = 0;
+    std::size_t count = 0;
+    mutable std::mutex mutex;
+
+    std::thread thread;
+    std::mutex waiting;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    // Counters from the previous sample, which usage is measured against
+    uint64_t last_busy = 0;
+    uint64_t last_total = 0;
+    uint64_t last_own = 0;
+    bool primed = false;
+
+    bool read(ResourceSample& sample);
+    void run(int period);
+
+public:
+    ~ResourceSampler();
+
+    void start(int period);
+    void stop();
+
+    bool sample();
+
+    std::size_t copy(ResourceSample* out, std::size_t max) const;
+    bool latest(ResourceSample& sample) const;
+};
+
+#endif // SAMPLER_H
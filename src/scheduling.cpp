@@ -0,0 +1,192 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/scheduling.cpp
+DESCRIPTION: Priority, affinity and efficiency mode of the monitor thread
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "scheduling.h"
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+
+static const char* PRIORITY_NAMES[] = {"idle", "lowest", "below_normal", "normal", "above_normal"};
+
+const char* priority_name(int priority) {
+    if ((priority < Priorities::IDLE) || (priority > Priorities::ABOVE_NORMAL)) return "unknown";
+    return PRIORITY_NAMES[priority];
+}
+
+void WorkerPolicy::configure(const Settings& settings) {
+    /*
+    Read `worker_priority`, `worker_affinity` and `worker_efficiency`.
+
+    The affinity is a mask of CPUs, in decimal or with a 0x prefix in hex.
+    */
+
+    std::string name = settings.get<std::string>("worker_priority", "below_normal");
+
+    priority = Priorities::BELOW_NORMAL;
+    for (int i = Priorities::IDLE; i <= Priorities::ABOVE_NORMAL; i++) {
+        if (name == PRIORITY_NAMES[i]) priority = i;
+    }
+
+    std::string mask = settings.get<std::string>("worker_affinity", "0");
+    affinity = std::strtoull(mask.c_str(), nullptr, 0);
+
+    efficient = settings.get<bool>("worker_efficiency", false);
+}
+
+bool WorkerPolicy::operator==(const WorkerPolicy& other) const {
+    return (priority == other.priority) &&
+           (affinity == other.affinity) &&
+           (efficient == other.efficient);
+}
+
+#ifdef _WIN32
+
+// Declared by newer SDKs only, and SetThreadInformation() is missing before
+// Windows 8, so both are resolved at runtime
+struct ThreadPowerThrottlingState {
+    ULONG Version;
+    ULONG ControlMask;
+    ULONG StateMask;
+};
+
+#define THREAD_POWER_THROTTLING_CLASS 3
+#define THREAD_POWER_THROTTLING_EXECUTION_SPEED_FLAG 0x1
+
+typedef BOOL (WINAPI *SetThreadInformationFunction)(HANDLE, int, LPVOID, DWORD);
+
+static bool set_efficiency(bool enabled) {
+    static auto set_information = reinterpret_cast<SetThreadInformationFunction>(
+        GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "SetThreadInformation"));
+    if (!set_information) return false;
+
+    // Leaving the flag out of the state hands the decision back to Windows
+    ThreadPowerThrottlingState state = {};
+    state.Version = 1;
+    state.ControlMask = THREAD_POWER_THROTTLING_EXECUTION_SPEED_FLAG;
+    state.StateMask = enabled ? THREAD_POWER_THROTTLING_EXECUTION_SPEED_FLAG : 0;
+
+    return set_information(GetCurrentThread(), THREAD_POWER_THROTTLING_CLASS, &state, sizeof(state)) != 0;
+}
+
+#else
+
+// Layout of the sched_setattr() argument, which glibc does not declare
+struct SchedAttr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+    uint32_t sched_util_min;
+    uint32_t sched_util_max;
+};
+
+#define SCHED_FLAG_KEEP_ALL_FLAGS 0x18
+#define SCHED_FLAG_UTIL_CLAMP_MAX_FLAG 0x40
+
+// Utilization is out of 1024; a quarter keeps the thread on small cores
+#define EFFICIENT_UTILIZATION 256
+
+static bool set_efficiency(bool enabled) {
+    SchedAttr attributes = {};
+    attributes.size = sizeof(attributes);
+    attributes.sched_flags = SCHED_FLAG_KEEP_ALL_FLAGS | SCHED_FLAG_UTIL_CLAMP_MAX_FLAG;
+    attributes.sched_util_max = enabled ? EFFICIENT_UTILIZATION : 1024;
+
+    // Fails on kernels built without utilization clamping
+    return syscall(SYS_sched_setattr, 0, &attributes, 0) == 0;
+}
+
+#endif
+
+bool WorkerPolicy::apply() const {
+    /*
+    Apply the policy to the calling thread.
+
+    A lower priority reduces CPU contention by letting other applications
+    run first; on Linux it maps to the thread's nice value. Each part is
+    applied on its own, so one the OS refuses (e.g. a raised priority
+    without privileges) doesn't stop the rest. Returns false if any part
+    failed.
+    */
+
+    bool applied = true;
+
+#ifdef _WIN32
+    static const int PRIORITIES[] = {
+        THREAD_PRIORITY_IDLE,
+        THREAD_PRIORITY_LOWEST,
+        THREAD_PRIORITY_BELOW_NORMAL,
+        THREAD_PRIORITY_NORMAL,
+        THREAD_PRIORITY_ABOVE_NORMAL,
+    };
+
+    if (!SetThreadPriority(GetCurrentThread(), PRIORITIES[priority])) applied = false;
+
+    DWORD_PTR mask = static_cast<DWORD_PTR>(affinity);
+    if (mask == 0) {
+        DWORD_PTR system = 0;
+        GetProcessAffinityMask(GetCurrentProcess(), &mask, &system);
+    }
+    if (!SetThreadAffinityMask(GetCurrentThread(), mask)) applied = false;
+#else
+    static const int NICE[] = {19, 10, 5, 0, -5};
+
+    pid_t thread = static_cast<pid_t>(syscall(SYS_gettid));
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(thread), NICE[priority]) != 0) applied = false;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        bool allowed = (affinity == 0) || ((cpu < 64) && ((affinity >> cpu) & 1));
+        if (allowed) CPU_SET(cpu, &set);
+    }
+
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) applied = false;
+#endif
+
+    // Turning efficiency off fails harmlessly where it was never supported
+    if (!set_efficiency(efficient) && efficient) applied = false;
+
+    if (!applied) {
+        std::cerr << "Unable to fully apply the worker policy (priority "
+                  << priority_name(priority) << ", affinity 0x" << std::hex << affinity
+                  << std::dec << ", efficiency " << (efficient ? "on" : "off") << ")!\n";
+    }
+
+    return applied;
+}
@@ -0,0 +1,58 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/scheduling.h
+DESCRIPTION: Priority, affinity and efficiency mode of the monitor thread
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef SCHEDULING_H
+#define SCHEDULING_H
+
+#include <cstdint>
+
+#include "settings.h"
+
+
+namespace Priorities {
+    enum Priority {
+        // Only run when nothing else wants the CPU
+        IDLE = 0,
+        LOWEST,
+        BELOW_NORMAL,
+        NORMAL,
+        ABOVE_NORMAL,
+    };
+}
+
+struct WorkerPolicy {
+    int priority = Priorities::BELOW_NORMAL;
+    // Bit n allows CPU n; 0 allows every CPU
+    uint64_t affinity = 0;
+    // EcoQoS on Windows, a utilization clamp elsewhere, both of which steer
+    // the thread to efficiency cores and low clock speeds
+    bool efficient = false;
+
+    void configure(const Settings& settings);
+    bool apply() const;
+
+    bool operator==(const WorkerPolicy& other) const;
+};
+
+const char* priority_name(int priority);
+
+#endif // SCHEDULING_H
@@ -28,56 +28,188 @@ VERSION: 1.0.1
 #include <stdexcept>
 #include <cstring>
 #include <cerrno>
+#include <charconv>
+#include <cctype>
+#include <type_traits>
+#include <system_error>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
 
-bool Settings::load(const std::string& file_name) {
+
+static std::string_view trim(std::string_view text) {
+    // Spaces, tabs and the \r of CRLF line endings
+    std::size_t start = 0;
+    std::size_t end = text.size();
+
+    while ((start < end) && std::isspace(static_cast<unsigned char>(text[start]))) start++;
+    while ((end > start) && std::isspace(static_cast<unsigned char>(text[end - 1]))) end--;
+
+    return text.substr(start, end - start);
+}
+
+bool Settings::read(const std::string& file_name) {
     /*
-    Load settings from a file name.
-    
-    The filename is retained to allow `update()` to refresh it.
+    Read a whole file into `buffer` with a single read, reusing its
+    capacity.
     */
 
-    std::ifstream file(file_name);
-    if (!file.is_open()) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(file_name.c_str(), GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Error: Could not open file " << file_name
+                  << ". Reason: " << std::system_category().message(GetLastError()) << std::endl;
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    DWORD amount = 0;
+    bool complete = GetFileSizeEx(file, &size) && (size.QuadPart < MAXDWORD);
+
+    if (complete) {
+        buffer.resize(static_cast<std::size_t>(size.QuadPart));
+        complete = ReadFile(file, buffer.data(), static_cast<DWORD>(buffer.size()), &amount, nullptr);
+        buffer.resize(amount);
+    }
+
+    CloseHandle(file);
+    return complete;
+#else
+    int file = open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (file < 0) {
         std::cerr << "Error: Could not open file " << file_name
                   << ". Reason: " << std::strerror(errno) << std::endl;
         return false;
     }
 
-    this->path = file_name;
+    struct stat status;
+    bool complete = fstat(file, &status) == 0;
+
+    if (complete) {
+        buffer.resize(static_cast<std::size_t>(status.st_size));
+
+        // A single read, unless the file grew since it was measured
+        std::size_t amount = 0;
+        while (amount < buffer.size()) {
+            ssize_t length = ::read(file, buffer.data() + amount, buffer.size() - amount);
+            if (length <= 0) break;
+            amount += static_cast<std::size_t>(length);
+        }
+        buffer.resize(amount);
+    }
+
+    close(file);
+    return complete;
+#endif
+}
+
+bool Settings::parse() {
+    /*
+    Apply the file in `buffer`, then keep it as `contents`. Returns true if
+    any value changed.
+
+    The text is tokenized in place: each line, key and value is a view of
+    the buffer, and a value is only copied when it differs from the stored
+    one (reusing the stored string's capacity). Keys and values are trimmed
+    of surrounding whitespace, CRLF line endings and a UTF-8 byte order mark
+    are accepted, and lines that are empty, start with # or //, or have no
+    = are skipped. Settings removed from the file keep their last value, and
+    overridden ones keep their override.
+    */
+
+    // Held while applying, so other threads never see a value being
+    // reassigned or the map rehashing
+    std::unique_lock<std::shared_mutex> lock(mutex);
 
-    std::string line;
-    // Skip empty lines and lines that start with # or // as comments
-    while (std::getline(file, line)) {
-        if ((line.empty()) ||
-            (line[0] == '#') ||
-            (line.substr(0, 2) == "//")) continue;
+    bool changed = false;
+
+    std::string_view text = buffer;
+    if (text.substr(0, 3) == "\xEF\xBB\xBF") text.remove_prefix(3);
+
+    while (!text.empty()) {
+        std::size_t newline = text.find('\n');
+        std::string_view line = trim(text.substr(0, newline));
+        text.remove_prefix((newline == std::string_view::npos) ? text.size() : newline + 1);
+
+        if (line.empty() || (line[0] == '#') || (line.substr(0, 2) == "//")) continue;
 
         // Delimeter between key and value
-        auto delimeter = line.find('=');
-        if (delimeter == std::string::npos) continue;
+        std::size_t delimeter = line.find('=');
+        if (delimeter == std::string_view::npos) continue;
 
-        std::string key = line.substr(0, delimeter);
-        std::string value = line.substr(delimeter + 1);
-        settings[key] = value;
+        std::string_view key = trim(line.substr(0, delimeter));
+        std::string_view value = trim(line.substr(delimeter + 1));
+
+        if (overrides.find(key) != overrides.end()) continue;
+
+        auto it = settings.find(key);
+        if (it == settings.end()) {
+            settings.emplace(key, value);
+            changed = true;
+        }
+        else if (it->second != value) {
+            it->second.assign(value);
+            changed = true;
+        }
     }
 
+    contents.swap(buffer);
+    return changed;
+}
+
+bool Settings::load(const std::string& file_name) {
+    /*
+    Load settings from a file name.
+
+    The filename is retained to allow `update()` to refresh it.
+    */
+
+    std::lock_guard<std::mutex> reload(reloading);
+
+    if (!read(file_name)) return false;
+
+    if (this->path != file_name) this->path = file_name;
+
+    parse();
     return true;
 }
 
+void Settings::override(const std::string& key, const std::string& value) {
+    /*
+    Pin a setting to a value without touching the file. It survives
+    `update()` and later loads.
+    */
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+
+    overrides[key] = value;
+    settings[key] = value;
+}
+
 void Settings::print() const {
     /*
     Print to the console a comprehensive list of keys and values in the
     settings file.
     */
 
+    std::shared_lock<std::shared_mutex> lock(mutex);
+
     for (const auto& [key, value] : settings) {
         std::cout << key << " = " << value << "\n";
     }
 }
 
 template <typename T>
-T Settings::get(const std::string& key, T default_value) const {
+T Settings::get(std::string_view key, T default_value) const {
     /*
     Retrieve a value from the settings.
 
@@ -89,21 +221,37 @@ T Settings::get(const std::string& key, T default_value) const {
     ```
 
     The default value is used if the setting cannot be found.
+
+    Numbers are parsed in place, so reading a setting never allocates. The
+    monitor reads its settings every sweep.
     */
 
+    std::shared_lock<std::shared_mutex> lock(mutex);
+
     auto it = settings.find(key);
     if (it == settings.end()) return default_value;
 
-    std::istringstream ss(it->second);
     T value;
-    if (!(ss >> value)) {
-        throw std::runtime_error("Invalid type for key: " + key);
+
+    if constexpr (std::is_arithmetic_v<T>) {
+        const char* start = it->second.data();
+        const char* end = start + it->second.size();
+        while ((start < end) && std::isspace(static_cast<unsigned char>(*start))) start++;
+
+        if (std::from_chars(start, end, value).ec == std::errc()) return value;
+    }
+    else {
+        std::istringstream ss(it->second);
+        if (ss >> value) return value;
     }
-    return value;
+
+    throw std::runtime_error("Invalid type for key: " + std::string(key));
 }
 
 template <>
-bool Settings::get<bool>(const std::string& key, bool default_value) const {
+bool Settings::get<bool>(std::string_view key, bool default_value) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+
     auto it = settings.find(key);
     if (it == settings.end()) return default_value;
 
@@ -114,29 +262,129 @@ bool Settings::get<bool>(const std::string& key, bool default_value) const {
     return default_value;
 }
 
+template <>
+std::string Settings::get<std::string>(std::string_view key, std::string default_value) const {
+    // Return the raw value, so empty values and values with spaces survive
+    std::shared_lock<std::shared_mutex> lock(mutex);
+
+    auto it = settings.find(key);
+    if (it == settings.end()) return default_value;
+
+    return it->second;
+}
+
+bool Settings::copy(std::string_view key, std::string& value, std::string_view default_value) const {
+    /*
+    Copy a value, or the default if it can't be found, into `value`.
+
+    Returns whether `value` changed. Its capacity is reused, so copying a
+    setting that hasn't changed never allocates; callers that run every
+    sweep keep their own string and only act when this returns true.
+    */
+
+    std::shared_lock<std::shared_mutex> lock(mutex);
+
+    auto it = settings.find(key);
+    std::string_view found = (it == settings.end()) ? default_value : std::string_view(it->second);
+
+    if (value == found) return false;
+
+    value.assign(found);
+    return true;
+}
+
 bool Settings::set(const std::string& key, const std::string& value) {
-    settings[key] = value;
+    /*
+    Change a setting and save it to the file it was loaded from.
+
+    Only the lines assigning `key` get the new value; every other line,
+    comments and blank lines included, is written back exactly as it was,
+    and a key the file doesn't have yet is appended. The file is read again
+    first, so edits made to it since it was last loaded survive too, and are
+    applied by the next `update()`.
+    */
+
+    std::lock_guard<std::mutex> reload(reloading);
+
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        settings[key] = value;
+    }
 
     if (this->path.empty()) return false;
 
-    std::ofstream file(this->path);
+    // Fall back to the file as last parsed if it can't be read any more
+    std::string_view text = read(this->path) ? std::string_view(buffer) : std::string_view(contents);
+
+    std::string output;
+    output.reserve(text.size() + key.size() + value.size() + 2);
+
+    if (text.substr(0, 3) == "\xEF\xBB\xBF") {
+        output.append(text.substr(0, 3));
+        text.remove_prefix(3);
+    }
+
+    bool found = false;
+
+    while (!text.empty()) {
+        std::size_t newline = text.find('\n');
+        std::string_view raw = text.substr(0, (newline == std::string_view::npos) ? text.size() : newline + 1);
+        text.remove_prefix(raw.size());
+
+        // Matched the same way `parse()` reads it
+        std::string_view line = trim(raw);
+        std::size_t delimeter = line.find('=');
+
+        if (line.empty() || (line[0] == '#') || (line.substr(0, 2) == "//") ||
+            (delimeter == std::string_view::npos) || (trim(line.substr(0, delimeter)) != key)) {
+            output.append(raw);
+            continue;
+        }
+
+        // Keep the indentation, the key as written, the spacing around the
+        // = and the line ending; only the value itself is replaced
+        std::size_t offset = static_cast<std::size_t>(line.data() - raw.data());
+        std::size_t start = delimeter + 1;
+        while ((start < line.size()) && std::isspace(static_cast<unsigned char>(line[start]))) start++;
+
+        output.append(raw.substr(0, offset + start));
+        output.append(value);
+        output.append(raw.substr(offset + line.size()));
+        found = true;
+    }
+
+    if (!found) {
+        if (!output.empty() && (output.back() != '\n')) output.push_back('\n');
+        output.append(key).append("=").append(value).append("\n");
+    }
+
+    // Binary, so CRLF line endings are written back unchanged
+    std::ofstream file(this->path, std::ios::binary | std::ios::trunc);
     if (!file.is_open()) {
-        std::cerr << "Error: Could not open file " << this->path 
+        std::cerr << "Error: Could not open file " << this->path
                   << ". Reason: " << std::strerror(errno) << std::endl;
         return false;
     }
 
-    for (const auto& [key, value] : settings) {
-        file << key << "=" << value << "\n";
-    }
-
-    return true;
+    file.write(output.data(), static_cast<std::streamsize>(output.size()));
+    return static_cast<bool>(file);
 }
 
-void Settings::update() {
-    this->load(this->path);
+bool Settings::update() {
+    /*
+    Reload the settings from the file they were last loaded from.
+
+    Returns true if any value changed. The GUI calls this on every refresh,
+    so an unchanged file is only read and compared, never parsed.
+    */
+
+    std::lock_guard<std::mutex> reload(reloading);
+
+    if (this->path.empty() || !read(this->path)) return false;
+    if (buffer == contents) return false;
+
+    return parse();
 }
 
-template int Settings::get<int>(const std::string& key, int default_value) const;
-template double Settings::get<double>(const std::string& key, double default_value) const;
-template std::string Settings::get<std::string>(const std::string& key, std::string default_value) const;
+template int Settings::get<int>(std::string_view key, int default_value) const;
+template double Settings::get<double>(std::string_view key, double default_value) const;
@@ -25,23 +25,63 @@ VERSION: 1.0.1
 
 #include <unordered_map>
 #include <string>
+#include <string_view>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
 
+// Lets containers keyed by std::string be searched with a std::string_view,
+// so looking up a literal doesn't build a temporary string
+struct StringHash {
+    using is_transparent = void;
+
+    std::size_t operator()(std::string_view text) const {
+        return std::hash<std::string_view>{}(text);
+    }
+};
+
+typedef std::unordered_map<std::string, std::string, StringHash, std::equal_to<>> StringMap;
+
+// Read by the monitor thread every sweep while the GUI thread reloads it, so
+// values are only ever copied out under the lock, never referenced
 class Settings {
-    std::unordered_map<std::string, std::string> settings;
+    StringMap settings;
+    // Values that win over the file, e.g. from the command line
+    StringMap overrides;
+    // Guards `settings` and `overrides`
+    mutable std::shared_mutex mutex;
+
+    // Guards the path and buffers below, so loads and updates from different
+    // threads take turns
+    std::mutex reloading;
     std::string path;
 
+    // The file as last parsed, and the buffer the next read goes into. Both
+    // are kept across reloads, so rereading an unchanged file neither
+    // allocates nor touches `settings`.
+    std::string contents;
+    std::string buffer;
+
+    bool read(const std::string& file_name);
+    bool parse();
+
 public:
     bool load(const std::string& file_name);
 
     template <typename T>
-    T get(const std::string& key, T default_value = T()) const;
+    T get(std::string_view key, T default_value = T()) const;
+    bool copy(std::string_view key, std::string& value, std::string_view default_value) const;
 
     bool set(const std::string& key, const std::string& value);
+    void override(const std::string& key, const std::string& value);
     void print() const;
-    void update();
+    bool update();
 };
 
 template <>
-bool Settings::get<bool>(const std::string& key, bool default_value) const;
+bool Settings::get<bool>(std::string_view key, bool default_value) const;
+
+template <>
+std::string Settings::get<std::string>(std::string_view key, std::string default_value) const;
 
 #endif // SETTINGS_H
@@ -0,0 +1,234 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/shared.cpp
+DESCRIPTION: Shared-memory status segment and sweep lease
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "shared.h"
+
+#include <chrono>
+#include <cstring>
+#include <random>
+
+#ifndef _WIN32
+#include <csignal>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+
+static int64_t wall_clock() {
+    // The lease is compared across processes, so a steady clock won't do
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static bool process_alive(uint32_t pid) {
+#ifdef _WIN32
+    HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, pid);
+    if (!process) return false;
+
+    bool alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+    CloseHandle(process);
+    return alive;
+#else
+    return (kill(static_cast<pid_t>(pid), 0) == 0) || (errno == EPERM);
+#endif
+}
+
+uint64_t lease_token(uint32_t pid) {
+    /*
+    Make the token an engine holds the lease with.
+
+    The PID goes in the low 32 bits, which is all the liveness check looks
+    at. A random nonce goes in the high 32 bits, since one process can host
+    several engines (gui.dll and api.dll loaded by the same interpreter) and
+    the PID alone would let each of them take the other's lease for its own.
+    */
+
+    std::random_device random;
+
+    uint32_t nonce = 0;
+    while (nonce == 0) nonce = static_cast<uint32_t>(random());
+
+    return (static_cast<uint64_t>(nonce) << 32) | pid;
+}
+
+SharedSegment::~SharedSegment() {
+    this->close();
+}
+
+void SharedSegment::close() {
+#ifdef _WIN32
+    if (layout) UnmapViewOfFile(layout);
+    if (mapping) CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    if (layout) munmap(layout, sizeof(SharedLayout));
+    if (descriptor >= 0) ::close(descriptor);
+    descriptor = -1;
+#endif
+    layout = nullptr;
+}
+
+bool SharedSegment::open(const char* name) {
+    /*
+    Create the segment, or map the one another instance already created.
+
+    New segments are zero-filled by the OS, so the first instance to see an
+    empty header stamps it. A segment with another layout version is left
+    alone. Does nothing if already open.
+    */
+
+    if (layout) return true;
+
+    void* view = nullptr;
+
+#ifdef _WIN32
+    mapping = CreateFileMappingA(
+        INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+        0, static_cast<DWORD>(sizeof(SharedLayout)), name);
+    if (!mapping) return false;
+
+    view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(SharedLayout));
+    if (!view) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+        return false;
+    }
+#else
+    descriptor = shm_open(name, O_CREAT | O_RDWR | O_CLOEXEC, 0600);
+    if (descriptor < 0) return false;
+
+    if (ftruncate(descriptor, sizeof(SharedLayout)) == 0) {
+        view = mmap(nullptr, sizeof(SharedLayout), PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    }
+    if (!view || (view == MAP_FAILED)) {
+        ::close(descriptor);
+        descriptor = -1;
+        return false;
+    }
+#endif
+
+    SharedLayout* candidate = static_cast<SharedLayout*>(view);
+
+    // Two instances may race to stamp a fresh segment; both write the same
+    if (candidate->magic == 0) {
+        candidate->version = SHARED_STATUS_VERSION;
+        candidate->magic = SHARED_STATUS_MAGIC;
+    }
+
+    layout = candidate;
+
+    if ((layout->magic != SHARED_STATUS_MAGIC) || (layout->version != SHARED_STATUS_VERSION)) {
+        // Leave a segment from an incompatible build untouched
+        this->close();
+        return false;
+    }
+
+    return true;
+}
+
+bool SharedSegment::acquire_lease(uint64_t token, int duration) {
+    /*
+    Take or renew the lease that lets one instance sweep.
+
+    The lease is free if nobody holds it, if it expired, or if the process
+    of its holder has exited without releasing it. The holder must renew it
+    within `duration` milliseconds. Returns whether `token` holds the lease.
+    */
+
+    if (!layout) return true;
+
+    int64_t now = wall_clock();
+    uint64_t holder = layout->holder.load(std::memory_order_acquire);
+
+    if (holder != token) {
+        bool free = (holder == 0) ||
+                    (layout->expiry.load(std::memory_order_acquire) < now) ||
+                    !process_alive(static_cast<uint32_t>(holder));
+
+        if (!free) return false;
+        if (!layout->holder.compare_exchange_strong(holder, token, std::memory_order_acq_rel)) {
+            return false;
+        }
+    }
+
+    layout->expiry.store(now + duration, std::memory_order_release);
+    return true;
+}
+
+void SharedSegment::release_lease(uint64_t token) {
+    /*
+    Give up the lease, if held, so another instance can take over at once.
+    */
+
+    if (!layout) return;
+
+    uint64_t holder = token;
+    layout->holder.compare_exchange_strong(holder, 0, std::memory_order_acq_rel);
+}
+
+uint64_t SharedSegment::get_holder() const {
+    // The owning PID is the low 32 bits
+    return layout ? layout->holder.load(std::memory_order_acquire) : 0;
+}
+
+void SharedSegment::publish(const SharedStats& stats) {
+    /*
+    Write the counters for readers. Only the lease holder may publish.
+
+    The sequence is odd while writing, so a reader that overlaps a write
+    sees the change and retries instead of using a torn copy.
+    */
+
+    if (!layout) return;
+
+    uint32_t sequence = layout->sequence.load(std::memory_order_relaxed);
+    layout->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(&layout->stats, &stats, sizeof(SharedStats));
+
+    layout->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool SharedSegment::read(SharedStats& stats) const {
+    /*
+    Copy a consistent snapshot of the published counters, straight from the
+    mapping with no IPC. Returns false if the segment isn't open or the
+    owner kept writing through every retry.
+    */
+
+    if (!layout) return false;
+
+    for (int attempt = 0; attempt < 64; attempt++) {
+        uint32_t before = layout->sequence.load(std::memory_order_acquire);
+        if (before & 1) continue;
+
+        std::memcpy(&stats, &layout->stats, sizeof(SharedStats));
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (layout->sequence.load(std::memory_order_relaxed) == before) return true;
+    }
+
+    return false;
+}
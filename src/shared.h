@@ -0,0 +1,113 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/shared.h
+DESCRIPTION: Shared-memory status segment and sweep lease
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef SHARED_H
+#define SHARED_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Name of the segment every DieKnow instance in the session shares
+#ifdef _WIN32
+#define SHARED_STATUS_NAME "Local\\DieKnowStatus"
+#else
+#define SHARED_STATUS_NAME "/dieknow-status"
+#endif
+
+#define SHARED_STATUS_MAGIC 0x5453444B
+#define SHARED_STATUS_VERSION 2
+
+
+extern "C"
+{
+    // Counters published by the instance that holds the lease. Plain layout
+    // so it can be mirrored with a ctypes Structure.
+    struct SharedStats {
+        uint32_t owner;
+        int32_t running;
+        int32_t roots;
+        int32_t on_battery;
+        int64_t killed;
+        int64_t in_flight;
+        int64_t retried;
+        int64_t gave_up;
+        int64_t respawns_prevented;
+        double sweep_ms;
+        double usage;
+        double budget;
+        int32_t period_ms;
+        int32_t reserved;
+        // Milliseconds since the Unix epoch
+        int64_t updated;
+    };
+}
+
+// Layout of the segment. Every field is either atomic or guarded by the
+// sequence counter, so readers never take a lock.
+struct SharedLayout {
+    uint32_t magic;
+    uint32_t version;
+
+    // Odd while the owner is writing `stats`
+    std::atomic<uint32_t> sequence;
+
+    // Lease token of the engine holding the lease; see `lease_token`
+    std::atomic<uint64_t> holder;
+    // Milliseconds since the Unix epoch after which the lease is up for grabs
+    std::atomic<int64_t> expiry;
+
+    SharedStats stats;
+};
+
+uint64_t lease_token(uint32_t pid);
+
+class SharedSegment {
+    SharedLayout* layout = nullptr;
+
+#ifdef _WIN32
+    HANDLE mapping = nullptr;
+#else
+    int descriptor = -1;
+#endif
+
+    void close();
+
+public:
+    ~SharedSegment();
+
+    bool open(const char* name = SHARED_STATUS_NAME);
+    bool is_open() const { return layout != nullptr; }
+
+    bool acquire_lease(uint64_t token, int duration);
+    void release_lease(uint64_t token);
+    uint64_t get_holder() const;
+
+    void publish(const SharedStats& stats);
+    bool read(SharedStats& stats) const;
+};
+
+#endif // SHARED_H
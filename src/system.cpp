@@ -27,73 +27,10 @@ WNDPROC _proc = nullptr;
 
 
 const double WINDOW_DELAY = 0.7;
-const std::vector<std::string> WINDOW_EXCLUDE_LIST = {
-    "GDI+",
-    "DDE Server Window",
-    "Default IME",
-    "MSCTFIME UI",
-    ".NET-BroadcastEventWindow",
-    "DesktopWindowXamlSource",
-    "HardwareMonitorWindow",
-    "WISPTIS",
-    "SystemResourceNotifyWindow",
-    "DesktopWindow",
-    "Battery Meter",
-    "BluetoothNotificationAreaIconWindowClass",
-    "CiceroUIWndFrame",
-    "DesktopInfo",
-    "MediaContextNotificationWindow",
-    "TclNotifier",
-    "Task Switching",
-    "Task Host Window",
-    "Shell Handwriting Canvas",
-    "System tray overflow window.",
-    "SecurityHealthSystray",
-    "Win HCP",
-    "Windows Input Experience",
-    "OfficePowerManagerWindow",
-    "PopupHost",
-    "Progress",
-    "RealtekAudioAdminBackgroundProcessClass",
-    "CFD File Open Message Window",
-    "Core Sync",
-    "Desktop Info",
-    "Graphics Command Center",
-    "MenuWindow",
-    "Microsoft OneNote - Windows taskbar",
-    "MS_WebcheckMonitor",
-    "Network Flyout",
-    "Per Monitor Aware Window",
-    "Program Manager",
-    "Rtc Video PnP Listener",
-    "TtkMonitorWindow",
-    "Windows Push Notifications Platform",
-    "DWM Notification Window",
-    "Tooltip",
-    "Realtek Jack Windows"
-};
-
-bool Window::operator==(const Window& other) const {
-    return (title == other.title) &&
-           (class_name == other.class_name) &&
-           (hwnd == other.hwnd);
-}
-
-bool is_valid(const char* title) {
-    std::string caption(title);
-
-    for (const auto& word : WINDOW_EXCLUDE_LIST) {
-        if (caption.find(word) != std::string::npos) {
-            return false;
-        }
-    }
-
-    return true;
-}
 
 std::string get_cpu_name() {
     HKEY hkey;
-    char cpu_name[256];
+    char cpu_name[256] = "Unknown CPU";
     DWORD buffer_size = sizeof(cpu_name);
 
     if (RegOpenKeyExA(HKEY_LOCAL_MACHINE,
@@ -153,6 +90,27 @@ std::string get_available_ram() {
     return ram_info.str();
 }
 
+void SystemInfo::start() {
+    /*
+    Gather the CPU, GPU and OS names on a background thread. Does nothing if
+    they were already gathered or are being gathered.
+    */
+
+    if (thread.joinable() || ready) return;
+
+    thread = std::thread([this]() {
+        cpu = get_cpu_name();
+        gpu = get_gpu_name();
+        os = get_os_info();
+
+        ready = true;
+    });
+}
+
+SystemInfo::~SystemInfo() {
+    if (thread.joinable()) thread.join();
+}
+
 void press(BYTE key) {
     /*
     Press a key.
@@ -201,49 +159,6 @@ void toggle_internet() {
     push(0x1B); // Escape
 }
 
-BOOL CALLBACK enum_windows(HWND hwnd, LPARAM lParam) {
-    std::vector<Window>* windows = reinterpret_cast<std::vector<Window>*>(lParam);
-
-    char title[256];
-    char class_name[256];
-
-    GetWindowText(hwnd, title, sizeof(title));
-    GetClassNameA(hwnd, class_name, sizeof(class_name));
-
-    if (title[0]) {
-        if (is_valid(title)) {
-            windows->push_back({hwnd, title, class_name});
-        }
-    }
-
-    return TRUE;
-}
-
-BOOL CALLBACK enum_snapshot(HWND hwnd, LPARAM lParam) {
-    /*
-    Enumerate through a list of windows to be used as a snapshot.
-
-    The primary difference bteween `enum_windows()` is this uses the window
-    classname and checks if it is visible before pushing back, not if it is a
-    system window or not.
-    */
-
-    std::vector<Window>* windows = reinterpret_cast<std::vector<Window>*>(lParam);
-
-    char title[256];
-    char class_name[256];
-
-    GetWindowText(hwnd, title, sizeof(title));
-    GetClassNameA(hwnd, class_name, sizeof(class_name));
-
-    if ((class_name[0]) &&
-        (IsWindowVisible(hwnd))) {
-        windows->push_back({hwnd, title, class_name});
-    }
-
-    return TRUE;
-}
-
 LONG WINAPI ExceptionHandler(EXCEPTION_POINTERS* ExceptionInfo) {
     DWORD code = ExceptionInfo->ExceptionRecord->ExceptionCode;
     PVOID address = ExceptionInfo->ExceptionRecord->ExceptionAddress;
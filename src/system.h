@@ -32,33 +32,47 @@ VERSION: 1.0.1
 #include <chrono>
 #include <thread>
 #include <streambuf>
+#include <atomic>
 
 #include "settings.h"
+#include "window.h"
 
 
 extern const double WINDOW_DELAY;
-extern const std::vector<std::string> WINDOW_EXCLUDE_LIST;
 
 extern std::unordered_map<HWND, WNDPROC> original_procedures;
 extern WNDPROC _proc;
 
-struct Window {
-    HWND hwnd;
-    std::string title;
-    std::string class_name;
-
-    bool operator==(const Window& other) const;
-};
-
-bool is_valid(const char* title);
-
 std::string get_cpu_name();
 
 std::string get_gpu_name();
 
 std::string get_os_info();
 
-std::string get_avaliable_ram();
+std::string get_available_ram();
+
+// Hardware and OS facts that don't change while DieKnow runs. They are
+// gathered once on a background thread, so nothing waits on the registry or
+// the display driver.
+class SystemInfo {
+    std::thread thread;
+    std::atomic<bool> ready{false};
+
+    std::string cpu;
+    std::string gpu;
+    std::string os;
+
+public:
+    ~SystemInfo();
+
+    void start();
+    bool is_ready() const { return ready; }
+
+    // Only valid once `is_ready()`
+    const std::string& get_cpu() const { return cpu; }
+    const std::string& get_gpu() const { return gpu; }
+    const std::string& get_os() const { return os; }
+};
 
 void press(BYTE key);
 
@@ -68,8 +82,6 @@ inline void push(BYTE key);
 
 void toggle_internet();
 
-BOOL CALLBACK enum_windows(HWND hwnd, LPARAM lParam);
-
 LONG WINAPI ExceptionHandler(EXCEPTION_POINTERS* ExceptionInfo);
 
 class ErrorBuffer : public std::streambuf {
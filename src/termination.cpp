@@ -0,0 +1,219 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/termination.cpp
+DESCRIPTION: Non-blocking process termination with retries
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "termination.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+static Clock& default_clock() {
+    static SystemClock clock;
+    return clock;
+}
+
+Terminator::Terminator(HandleCache* cache, Clock* clock, ProcessControl* control)
+    : cache(cache), clock(clock ? clock : &default_clock()),
+      control(control ? control : &system_process_control()) {}
+
+Terminator::~Terminator() {
+    for (Kill& kill : kills) release(kill);
+}
+
+void Terminator::configure(const Settings& settings) {
+    /*
+    Read the termination policy.
+
+    `kill_timeout` is the deadline in milliseconds for each attempt,
+    `kill_retries` the amount of attempts after the first, and
+    `kill_escalation` either "force" or "graceful".
+    */
+
+    timeout = std::max(0, settings.get<int>("kill_timeout", 1000));
+    retries = std::max(0, settings.get<int>("kill_retries", 2));
+
+    std::string policy = settings.get<std::string>("kill_escalation", "force");
+    escalation = (policy == "graceful") ? Kills::GRACEFUL : Kills::FORCE;
+}
+
+void Terminator::release(Kill& kill) {
+    // A survivor's handle goes back to the cache for the next repeat kill
+    if (cache && (kill.state != Kills::CONFIRMED)) {
+        cache->checkin(kill.pid, kill.create_time, kill.handle);
+    }
+    else {
+        control->close(kill.handle);
+    }
+
+    kill.handle = INVALID_PROCESS_HANDLE;
+}
+
+bool Terminator::request(uint32_t pid, uint64_t create_time, const char* name, uint32_t target) {
+    /*
+    Start tracking the termination of a process.
+
+    The handle is opened now, so it stays bound to this process even if the
+    PID is reused while the kill is in flight. Nothing is signalled until the
+    next `advance()`. Returns false if the process is already being
+    terminated or can't be opened.
+    */
+
+    if (tracking(pid)) return false;
+
+    ProcessHandle handle = cache ? cache->checkout(pid, create_time) : control->open(pid);
+    if (handle == INVALID_PROCESS_HANDLE) return false;
+
+    Kill& kill = kills.emplace_back();
+    kill.pid = pid;
+    kill.create_time = create_time;
+
+    std::strncpy(kill.name, name, KILL_NAME_LENGTH - 1);
+    kill.name[KILL_NAME_LENGTH - 1] = '\0';
+    kill.target = target;
+
+    kill.handle = handle;
+    kill.state = Kills::REQUESTED;
+    kill.attempts = 0;
+    kill.requested = clock->now();
+    kill.deadline = kill.requested;
+
+    pending = kills.size();
+    return true;
+}
+
+bool Terminator::tracking(uint32_t pid) const {
+    for (const Kill& kill : kills) {
+        if (kill.pid == pid) return true;
+    }
+    return false;
+}
+
+void Terminator::signal(Kill& kill, std::chrono::steady_clock::time_point now) {
+    // Only the first attempt of a graceful policy is polite; if the process
+    // has nothing to ask, it is forced straight away
+    bool sent = false;
+    if ((escalation == Kills::GRACEFUL) && (kill.attempts == 0)) {
+        sent = control->request_close(kill.handle, kill.pid);
+    }
+    if (!sent) control->terminate(kill.handle);
+
+    kill.attempts++;
+    kill.state = Kills::WAITING;
+    kill.deadline = now + std::chrono::milliseconds(timeout);
+}
+
+std::size_t Terminator::advance(std::vector<Kill>& finished) {
+    /*
+    Move every kill in flight one step forward without blocking.
+
+    New kills are signalled, and waiting ones are checked for exit with a
+    zero timeout. A kill that misses its deadline is signalled again until
+    its retries run out, so a stuck process never delays the others.
+
+    Kills that were confirmed or given up on are appended to `finished`,
+    with their handles already released. Returns the amount still in
+    flight.
+    */
+
+    auto now = clock->now();
+
+    for (std::size_t i = 0; i < kills.size();) {
+        Kill& kill = kills[i];
+
+        if (kill.state == Kills::REQUESTED) {
+            signal(kill, now);
+        }
+        else if (control->wait(kill.handle, 0)) {
+            kill.state = Kills::CONFIRMED;
+            confirmed++;
+        }
+        else if (now >= kill.deadline) {
+            if (kill.attempts <= retries) {
+                kill.state = Kills::RETRY;
+                retried++;
+                signal(kill, now);
+            }
+            else {
+                kill.state = Kills::GAVE_UP;
+                gave_up++;
+            }
+        }
+
+        if ((kill.state == Kills::CONFIRMED) || (kill.state == Kills::GAVE_UP)) {
+            release(kill);
+            finished.push_back(kill);
+
+            // Erased in place, so kills are still signalled in request order
+            kills.erase(kills.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+        else {
+            i++;
+        }
+    }
+
+    pending = kills.size();
+    return kills.size();
+}
+
+int Terminator::next_deadline() const {
+    /*
+    Retrieve the milliseconds until the earliest deadline in flight, 0 if one
+    has passed, or -1 if nothing is in flight.
+    */
+
+    if (kills.empty()) return -1;
+
+    auto now = clock->now();
+    auto earliest = kills.front().deadline;
+
+    for (const Kill& kill : kills) earliest = std::min(earliest, kill.deadline);
+
+    if (earliest <= now) return 0;
+
+    return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(earliest - now).count());
+}
+
+void Terminator::wait(int timeout) {
+    /*
+    Block for up to `timeout` milliseconds, returning early at the next
+    deadline or once the oldest kill in flight exits.
+
+    The monitor waits here between sweeps while kills are in flight, so it
+    wakes for a retry or an exit instead of sleeping out the interval. Call
+    `advance()` afterwards to act on whatever woke it.
+
+    The time passes on the clock, which checks for the exit every
+    `KILL_POLL_INTERVAL` milliseconds, so a `ManualClock` moves straight to
+    the deadline instead of the wait blocking in real time.
+    */
+
+    if (kills.empty()) return;
+
+    int remaining = next_deadline();
+    if ((remaining < 0) || (remaining > timeout)) remaining = timeout;
+
+    while (!control->wait(kills.front().handle, 0) && (remaining > 0)) {
+        int slice = std::min(remaining, KILL_POLL_INTERVAL);
+        clock->sleep(std::chrono::milliseconds(slice));
+        remaining -= slice;
+    }
+}
@@ -0,0 +1,124 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/termination.h
+DESCRIPTION: Non-blocking process termination with retries
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef TERMINATION_H
+#define TERMINATION_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <chrono>
+#include <atomic>
+
+#include "handles.h"
+#include "settings.h"
+#include "clock.h"
+
+// Length of the name carried by a kill, including the null terminator
+#define KILL_NAME_LENGTH 260
+// Milliseconds between checks for an exit while waiting on a kill
+#define KILL_POLL_INTERVAL 10
+
+
+namespace Kills {
+    enum State {
+        // Tracked, but not signalled yet
+        REQUESTED = 0,
+        // Signalled, waiting for the process to exit before the deadline
+        WAITING,
+        // Missed a deadline and about to be signalled again
+        RETRY,
+        // The process exited
+        CONFIRMED,
+        // Every attempt missed its deadline
+        GAVE_UP,
+    };
+
+    enum Escalation {
+        // Every attempt terminates the process outright
+        FORCE = 0,
+        // The first attempt asks the process to close, retries force it
+        GRACEFUL,
+    };
+}
+
+struct Kill {
+    uint32_t pid;
+    uint64_t create_time;
+    char name[KILL_NAME_LENGTH];
+    // ID in the `TargetRegistry`, or `TARGET_NONE`
+    uint32_t target;
+
+    ProcessHandle handle;
+    int state;
+    // Attempts signalled so far
+    int attempts;
+
+    std::chrono::steady_clock::time_point requested;
+    std::chrono::steady_clock::time_point deadline;
+};
+
+class Terminator {
+    std::vector<Kill> kills;
+
+    // Where handles come from and go back to, or nullptr to open and close
+    // them directly
+    HandleCache* cache;
+    // Where deadlines and request times are read from
+    Clock* clock;
+    // How processes are opened, signalled and checked
+    ProcessControl* control;
+
+    int timeout = 1000;
+    int retries = 2;
+    int escalation = Kills::FORCE;
+
+    // Read from other threads for statistics
+    std::atomic<std::size_t> pending{0};
+    std::atomic<std::size_t> confirmed{0};
+    std::atomic<std::size_t> retried{0};
+    std::atomic<std::size_t> gave_up{0};
+
+    void signal(Kill& kill, std::chrono::steady_clock::time_point now);
+    void release(Kill& kill);
+
+public:
+    explicit Terminator(HandleCache* cache = nullptr, Clock* clock = nullptr,
+                        ProcessControl* control = nullptr);
+    ~Terminator();
+
+    void configure(const Settings& settings);
+
+    bool request(uint32_t pid, uint64_t create_time, const char* name, uint32_t target = UINT32_MAX);
+    bool tracking(uint32_t pid) const;
+
+    std::size_t advance(std::vector<Kill>& finished);
+    int next_deadline() const;
+    void wait(int timeout);
+
+    std::size_t in_flight() const { return pending; }
+    std::size_t get_confirmed() const { return confirmed; }
+    std::size_t get_retried() const { return retried; }
+    std::size_t get_gave_up() const { return gave_up; }
+};
+
+#endif // TERMINATION_H
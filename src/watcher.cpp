@@ -0,0 +1,266 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/watcher.cpp
+DESCRIPTION: Change notifications for monitored folders
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "watcher.h"
+
+#include <algorithm>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+
+#ifdef _WIN32
+
+ChangeNotificationWatcher::~ChangeNotificationWatcher() {
+    for (Tree& tree : trees) {
+        if (tree.notification != INVALID_HANDLE_VALUE) FindCloseChangeNotification(tree.notification);
+    }
+}
+
+ChangeNotificationWatcher::Tree* ChangeNotificationWatcher::find(std::string_view root) {
+    for (Tree& tree : trees) {
+        if (tree.root == root) return &tree;
+    }
+    return nullptr;
+}
+
+bool ChangeNotificationWatcher::watch(const std::string& root) {
+    /*
+    Ask Windows to signal a change anywhere under `root`.
+
+    One notification covers the whole tree. Only names are watched: a file
+    or folder being added, removed or renamed, which is all that changes
+    what discovery finds.
+    */
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Tree* tree = this->find(root);
+    if (!tree) tree = &trees.emplace_back(Tree{root, INVALID_HANDLE_VALUE});
+
+    if (tree->notification != INVALID_HANDLE_VALUE) FindCloseChangeNotification(tree->notification);
+
+    tree->notification = FindFirstChangeNotificationA(
+        root.c_str(), TRUE, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME);
+
+    return tree->notification != INVALID_HANDLE_VALUE;
+}
+
+bool ChangeNotificationWatcher::add(const std::string& root, const std::filesystem::path& folder) {
+    // Already covered by the notification on the root
+    (void)root;
+    (void)folder;
+    return true;
+}
+
+void ChangeNotificationWatcher::forget(std::string_view root) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto it = trees.begin(); it != trees.end(); ++it) {
+        if (it->root != root) continue;
+
+        if (it->notification != INVALID_HANDLE_VALUE) FindCloseChangeNotification(it->notification);
+        trees.erase(it);
+        return;
+    }
+}
+
+bool ChangeNotificationWatcher::watching(std::string_view root) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Tree* tree = this->find(root);
+    return tree && (tree->notification != INVALID_HANDLE_VALUE);
+}
+
+bool ChangeNotificationWatcher::changed(std::string_view root) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Tree* tree = this->find(root);
+    if (!tree || (tree->notification == INVALID_HANDLE_VALUE)) return true;
+
+    if (WaitForSingleObject(tree->notification, 0) != WAIT_OBJECT_0) return false;
+
+    FindNextChangeNotification(tree->notification);
+    return true;
+}
+
+#else
+
+// Everything that adds, removes or renames an entry of a folder, or the
+// folder itself
+#define INOTIFY_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | \
+                      IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+InotifyWatcher::InotifyWatcher() {
+    descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+}
+
+InotifyWatcher::~InotifyWatcher() {
+    if (descriptor >= 0) close(descriptor);
+}
+
+InotifyWatcher::Tree* InotifyWatcher::find(std::string_view root) {
+    for (Tree& tree : trees) {
+        if (tree.root == root) return &tree;
+    }
+    return nullptr;
+}
+
+bool InotifyWatcher::shared(int watch, const Tree& except) const {
+    // The same folder under two nested roots has a single watch
+    for (const Tree& tree : trees) {
+        if (&tree == &except) continue;
+        if (std::binary_search(tree.watches.begin(), tree.watches.end(), watch)) return true;
+    }
+    return false;
+}
+
+void InotifyWatcher::release(Tree& tree) {
+    for (int watch : tree.watches) {
+        if (!this->shared(watch, tree)) inotify_rm_watch(descriptor, watch);
+    }
+    tree.watches.clear();
+}
+
+void InotifyWatcher::drain() {
+    /*
+    Read every pending event without blocking, and mark each tree with a
+    changed folder as dirty.
+    */
+
+    alignas(inotify_event) char buffer[4096];
+
+    while (true) {
+        ssize_t length = read(descriptor, buffer, sizeof(buffer));
+        if (length <= 0) break;
+
+        for (ssize_t position = 0; position < length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + position);
+            position += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            // Sent for every watch removed, including by `release()`
+            if (event->mask & IN_IGNORED) continue;
+
+            for (Tree& tree : trees) {
+                if ((event->mask & IN_Q_OVERFLOW) ||
+                    std::binary_search(tree.watches.begin(), tree.watches.end(), event->wd)) {
+                    tree.dirty = true;
+                }
+            }
+        }
+    }
+}
+
+bool InotifyWatcher::watch(const std::string& root) {
+    /*
+    Start watching `root` afresh. Its folders are added one by one as the
+    walk reaches them, before each is read.
+    */
+
+    if (descriptor < 0) return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Events already queued belong to the walk being replaced
+    this->drain();
+
+    Tree* tree = this->find(root);
+    if (!tree) tree = &trees.emplace_back();
+
+    this->release(*tree);
+    tree->root = root;
+    tree->dirty = false;
+    tree->broken = false;
+
+    return true;
+}
+
+bool InotifyWatcher::add(const std::string& root, const std::filesystem::path& folder) {
+    if (descriptor < 0) return false;
+
+    int watch = inotify_add_watch(descriptor, folder.c_str(), INOTIFY_MASK);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Tree* tree = this->find(root);
+    if (!tree) return false;
+
+    if (watch < 0) {
+        tree->broken = true;
+        return false;
+    }
+
+    auto it = std::lower_bound(tree->watches.begin(), tree->watches.end(), watch);
+    if ((it == tree->watches.end()) || (*it != watch)) tree->watches.insert(it, watch);
+
+    return true;
+}
+
+void InotifyWatcher::forget(std::string_view root) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto it = trees.begin(); it != trees.end(); ++it) {
+        if (it->root != root) continue;
+
+        this->release(*it);
+        trees.erase(it);
+        return;
+    }
+}
+
+bool InotifyWatcher::watching(std::string_view root) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Tree* tree = this->find(root);
+    return (descriptor >= 0) && tree && !tree->broken;
+}
+
+bool InotifyWatcher::changed(std::string_view root) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Tree* tree = this->find(root);
+    if ((descriptor < 0) || !tree || tree->broken) return true;
+
+    this->drain();
+
+    bool dirty = tree->dirty;
+    tree->dirty = false;
+    return dirty;
+}
+
+#endif
+
+std::unique_ptr<FolderWatcher> create_folder_watcher() {
+    /*
+    Create the change watcher for this platform: change notifications on
+    Windows, inotify elsewhere.
+    */
+
+#ifdef _WIN32
+    return std::make_unique<ChangeNotificationWatcher>();
+#else
+    return std::make_unique<InotifyWatcher>();
+#endif
+}
@@ -0,0 +1,123 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/watcher.h
+DESCRIPTION: Change notifications for monitored folders
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef WATCHER_H
+#define WATCHER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+
+// Tells the discovery engine whether a folder tree changed since it was last
+// walked, so an unchanged tree costs nothing at all to check
+class FolderWatcher {
+public:
+    virtual ~FolderWatcher() = default;
+
+    // Start watching `root` afresh, dropping its earlier watch. Called before
+    // a walk, so nothing that changes during the walk is missed.
+    virtual bool watch(const std::string& root) = 0;
+    // Also watch `folder`, found under `root` by the walk. Called from every
+    // discovery worker at once.
+    virtual bool add(const std::string& root, const std::filesystem::path& folder) = 0;
+    virtual void forget(std::string_view root) = 0;
+
+    // Whether every folder of `root` is watched, i.e. `changed()` can be
+    // trusted for it
+    virtual bool watching(std::string_view root) = 0;
+    // Whether an entry under `root` was added, removed or renamed since it
+    // was watched or last asked
+    virtual bool changed(std::string_view root) = 0;
+};
+
+#ifdef _WIN32
+
+class ChangeNotificationWatcher : public FolderWatcher {
+    struct Tree {
+        std::string root;
+        // Watches the whole tree, however deep
+        HANDLE notification;
+    };
+
+    std::mutex mutex;
+    std::vector<Tree> trees;
+
+    Tree* find(std::string_view root);
+
+public:
+    ~ChangeNotificationWatcher() override;
+
+    bool watch(const std::string& root) override;
+    bool add(const std::string& root, const std::filesystem::path& folder) override;
+    void forget(std::string_view root) override;
+
+    bool watching(std::string_view root) override;
+    bool changed(std::string_view root) override;
+};
+
+#else
+
+class InotifyWatcher : public FolderWatcher {
+    struct Tree {
+        std::string root;
+        // One per folder, since inotify doesn't watch subfolders. Sorted.
+        std::vector<int> watches;
+        bool dirty = false;
+        // A folder couldn't be watched, e.g. past the system's watch limit
+        bool broken = false;
+    };
+
+    int descriptor = -1;
+
+    std::mutex mutex;
+    std::vector<Tree> trees;
+
+    Tree* find(std::string_view root);
+    bool shared(int watch, const Tree& except) const;
+    void release(Tree& tree);
+    void drain();
+
+public:
+    InotifyWatcher();
+    ~InotifyWatcher() override;
+
+    bool watch(const std::string& root) override;
+    bool add(const std::string& root, const std::filesystem::path& folder) override;
+    void forget(std::string_view root) override;
+
+    bool watching(std::string_view root) override;
+    bool changed(std::string_view root) override;
+};
+
+#endif
+
+std::unique_ptr<FolderWatcher> create_folder_watcher();
+
+#endif // WATCHER_H
@@ -0,0 +1,190 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/window.cpp
+DESCRIPTION: Window listing for the GUI
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#include "window.h"
+
+#include <string_view>
+
+
+// Titles of the system windows left out of the window list
+const std::vector<std::string> WINDOW_EXCLUDE_LIST = {
+    "GDI+",
+    "DDE Server Window",
+    "Default IME",
+    "MSCTFIME UI",
+    ".NET-BroadcastEventWindow",
+    "DesktopWindowXamlSource",
+    "HardwareMonitorWindow",
+    "WISPTIS",
+    "SystemResourceNotifyWindow",
+    "DesktopWindow",
+    "Battery Meter",
+    "BluetoothNotificationAreaIconWindowClass",
+    "CiceroUIWndFrame",
+    "DesktopInfo",
+    "MediaContextNotificationWindow",
+    "TclNotifier",
+    "Task Switching",
+    "Task Host Window",
+    "Shell Handwriting Canvas",
+    "System tray overflow window.",
+    "SecurityHealthSystray",
+    "Win HCP",
+    "Windows Input Experience",
+    "OfficePowerManagerWindow",
+    "PopupHost",
+    "Progress",
+    "RealtekAudioAdminBackgroundProcessClass",
+    "CFD File Open Message Window",
+    "Core Sync",
+    "Desktop Info",
+    "Graphics Command Center",
+    "MenuWindow",
+    "Microsoft OneNote - Windows taskbar",
+    "MS_WebcheckMonitor",
+    "Network Flyout",
+    "Per Monitor Aware Window",
+    "Program Manager",
+    "Rtc Video PnP Listener",
+    "TtkMonitorWindow",
+    "Windows Push Notifications Platform",
+    "DWM Notification Window",
+    "Tooltip",
+    "Realtek Jack Windows"
+};
+
+bool Window::operator==(const Window& other) const {
+    return (title == other.title) &&
+           (class_name == other.class_name) &&
+           (id == other.id);
+}
+
+bool is_valid(const char* title) {
+    std::string_view caption(title);
+
+    for (const auto& word : WINDOW_EXCLUDE_LIST) {
+        if (caption.find(word) != std::string_view::npos) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#ifdef _WIN32
+
+static BOOL CALLBACK enum_windows(HWND hwnd, LPARAM lParam) {
+    std::vector<Window>* windows = reinterpret_cast<std::vector<Window>*>(lParam);
+
+    char title[256];
+    char class_name[256];
+
+    GetWindowText(hwnd, title, sizeof(title));
+    GetClassNameA(hwnd, class_name, sizeof(class_name));
+
+    if (title[0]) {
+        if (is_valid(title)) {
+            windows->push_back({
+                reinterpret_cast<uint64_t>(hwnd), title, class_name, IsWindowVisible(hwnd) != FALSE
+            });
+        }
+    }
+
+    return TRUE;
+}
+
+static BOOL CALLBACK enum_snapshot(HWND hwnd, LPARAM lParam) {
+    /*
+    Enumerate through a list of windows to be used as a snapshot.
+
+    The primary difference bteween `enum_windows()` is this uses the window
+    classname and checks if it is visible before pushing back, not if it is a
+    system window or not.
+    */
+
+    std::vector<Window>* windows = reinterpret_cast<std::vector<Window>*>(lParam);
+
+    char title[256];
+    char class_name[256];
+
+    GetWindowText(hwnd, title, sizeof(title));
+    GetClassNameA(hwnd, class_name, sizeof(class_name));
+
+    if ((class_name[0]) &&
+        (IsWindowVisible(hwnd))) {
+        windows->push_back({reinterpret_cast<uint64_t>(hwnd), title, class_name, true});
+    }
+
+    return TRUE;
+}
+
+bool Win32WindowSource::list(std::vector<Window>& windows) {
+    windows.clear();
+    return EnumWindows(enum_windows, reinterpret_cast<LPARAM>(&windows)) != FALSE;
+}
+
+bool Win32WindowSource::snapshot(std::vector<Window>& windows) {
+    windows.clear();
+    return EnumWindows(enum_snapshot, reinterpret_cast<LPARAM>(&windows)) != FALSE;
+}
+
+#endif
+
+void FakeWindowSource::set(const std::vector<Window>& windows) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->windows = windows;
+}
+
+bool FakeWindowSource::list(std::vector<Window>& windows) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    windows.clear();
+    for (const Window& window : this->windows) {
+        if (!window.title.empty() && is_valid(window.title.c_str())) windows.push_back(window);
+    }
+
+    return true;
+}
+
+bool FakeWindowSource::snapshot(std::vector<Window>& windows) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    windows.clear();
+    for (const Window& window : this->windows) {
+        if (!window.class_name.empty() && window.visible) windows.push_back(window);
+    }
+
+    return true;
+}
+
+std::unique_ptr<WindowSource> create_window_source() {
+    /*
+    Create the window source for this platform. Only Windows has windows to
+    list; elsewhere an empty fake stands in.
+    */
+
+#ifdef _WIN32
+    return std::make_unique<Win32WindowSource>();
+#else
+    return std::make_unique<FakeWindowSource>();
+#endif
+}
@@ -0,0 +1,95 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: src/window.h
+DESCRIPTION: Window listing for the GUI
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+*/
+
+#ifndef WINDOW_H
+#define WINDOW_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+
+extern const std::vector<std::string> WINDOW_EXCLUDE_LIST;
+
+struct Window {
+    // The window handle on Windows. Only ever compared.
+    uint64_t id;
+    std::string title;
+    std::string class_name;
+    bool visible;
+
+    // Visibility is left out, as it is shown as a check box rather than as a
+    // row of its own
+    bool operator==(const Window& other) const;
+};
+
+bool is_valid(const char* title);
+
+// Where the GUI lists windows from, so its window list logic builds and runs
+// without a desktop
+class WindowSource {
+public:
+    virtual ~WindowSource() = default;
+
+    // Replace `windows` with every titled window that isn't a system window
+    // (see `WINDOW_EXCLUDE_LIST`)
+    virtual bool list(std::vector<Window>& windows) = 0;
+    // Replace `windows` with every visible window that has a class name
+    virtual bool snapshot(std::vector<Window>& windows) = 0;
+
+    virtual const char* name() const = 0;
+};
+
+#ifdef _WIN32
+
+class Win32WindowSource : public WindowSource {
+public:
+    bool list(std::vector<Window>& windows) override;
+    bool snapshot(std::vector<Window>& windows) override;
+    const char* name() const override { return "win32"; }
+};
+
+#endif
+
+// Lists whatever windows it was given, filtered like the real ones. Used
+// where there is no desktop to list, and by tests.
+class FakeWindowSource : public WindowSource {
+    std::mutex mutex;
+    std::vector<Window> windows;
+
+public:
+    void set(const std::vector<Window>& windows);
+
+    bool list(std::vector<Window>& windows) override;
+    bool snapshot(std::vector<Window>& windows) override;
+    const char* name() const override { return "fake"; }
+};
+
+std::unique_ptr<WindowSource> create_window_source();
+
+#endif // WINDOW_H
@@ -0,0 +1,832 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: tests/benchmark.cpp
+DESCRIPTION: Benchmarks for the DieKnow engine
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+
+Compile with g++ -O2 -std=c++20 -o benchmark tests/benchmark.cpp src/engine.cpp src/settings.cpp src/events.cpp src/discovery.cpp src/watcher.cpp src/identity.cpp src/process.cpp src/handles.cpp src/termination.cpp src/roots.cpp src/scheduling.cpp src/governor.cpp src/power.cpp src/activity.cpp src/shared.cpp src/journal.cpp src/metrics.cpp src/pipe.cpp src/clock.cpp src/registry.cpp
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <random>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <filesystem>
+
+#include "../src/process.h"
+#include "../src/scheduling.h"
+#include "../src/governor.h"
+#include "../src/events.h"
+#include "../src/journal.h"
+#include "../src/settings.h"
+#include "../src/engine.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+typedef HANDLE Child;
+#else
+typedef pid_t Child;
+#endif
+
+std::vector<Child> spawn(const char* self, int count) {
+    /*
+    Start `count` idle child processes, so enumeration can be measured on a
+    crowded process table.
+    */
+
+    std::vector<Child> children;
+
+    for (int i = 0; i < count; i++) {
+#ifdef _WIN32
+        std::string command = std::string("\"") + self + "\" idle";
+
+        STARTUPINFOA si = {};
+        si.cb = sizeof(si);
+        PROCESS_INFORMATION pi = {};
+
+        if (!CreateProcessA(nullptr, command.data(), nullptr, nullptr, FALSE,
+                            CREATE_NO_WINDOW, nullptr, nullptr, &si, &pi)) {
+            break;
+        }
+
+        CloseHandle(pi.hThread);
+        children.push_back(pi.hProcess);
+#else
+        (void)self;
+        pid_t pid = fork();
+        if (pid < 0) break;
+        if (pid == 0) {
+            pause();
+            _exit(0);
+        }
+        children.push_back(pid);
+#endif
+    }
+
+    return children;
+}
+
+void reap(std::vector<Child>& children) {
+    for (Child child : children) {
+#ifdef _WIN32
+        TerminateProcess(child, 0);
+        CloseHandle(child);
+#else
+        kill(child, SIGKILL);
+        waitpid(child, nullptr, 0);
+#endif
+    }
+    children.clear();
+}
+
+void report(const char* label, std::vector<double>& timings, std::size_t count) {
+    std::sort(timings.begin(), timings.end());
+
+    double total = 0;
+    for (double timing : timings) total += timing;
+
+    std::cout << std::left << std::setw(12) << label
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << count << " processes"
+              << std::setw(12) << timings[timings.size() / 2] << " us median"
+              << std::setw(12) << (total / timings.size()) << " us mean"
+              << std::setw(12) << timings.front() << " us best\n";
+}
+
+void benchmark_process(const char* self, int extra, int iterations) {
+    /*
+    Time one snapshot of every process enumeration backend.
+
+    Each backend is warmed up once, so the reused buffers are already sized
+    and only the steady-state sweep cost is measured.
+    */
+
+    std::vector<Child> children = spawn(self, extra);
+    std::cout << "Spawned " << children.size() << " idle process(es).\n";
+
+#ifdef _WIN32
+    const char* backends[] = {"toolhelp", "ntquery"};
+#else
+    const char* backends[] = {"procfs"};
+#endif
+
+    for (const char* backend : backends) {
+        auto source = create_process_source(backend);
+        std::vector<ProcessInfo> processes;
+        std::vector<double> timings;
+
+        source->snapshot(processes);
+
+        for (int i = 0; i < iterations; i++) {
+            auto start = std::chrono::steady_clock::now();
+            source->snapshot(processes);
+            auto end = std::chrono::steady_clock::now();
+
+            timings.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+
+        report(source->name(), timings, processes.size());
+    }
+
+    reap(children);
+}
+
+uint64_t spin(int rounds) {
+    // Fixed amount of CPU work, standing in for one sweep
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (int i = 0; i < rounds; i++) {
+        hash = (hash ^ static_cast<uint64_t>(i)) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+bool read_energy(uint64_t& microjoules) {
+    /*
+    Read the package energy counter, where the platform exposes one (RAPL
+    through powercap on Linux). Elsewhere, power has to be measured
+    externally.
+    */
+
+#ifdef _WIN32
+    (void)microjoules;
+    return false;
+#else
+    std::ifstream file("/sys/class/powercap/intel-rapl:0/energy_uj");
+    return static_cast<bool>(file >> microjoules);
+#endif
+}
+
+void benchmark_policy(int iterations) {
+    /*
+    Time a fixed workload and a 1 ms sleep under every worker policy, pinned
+    to each CPU in turn.
+
+    On hybrid CPUs the per-CPU rows show the P-core/E-core split, and the
+    efficiency rows show how much latency EcoQoS trades for power. The work
+    latency is the wall time of the workload and the wake latency how late
+    the sleep returns, which grows when the thread has to wait for a core.
+    */
+
+    struct Mode {
+        const char* label;
+        int priority;
+        bool efficient;
+    };
+
+    const Mode modes[] = {
+        {"normal", Priorities::NORMAL, false},
+        {"below", Priorities::BELOW_NORMAL, false},
+        {"idle", Priorities::IDLE, false},
+        {"eco", Priorities::BELOW_NORMAL, true},
+    };
+
+    int cpus = std::min(64, static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+
+    std::cout << std::left << std::setw(8) << "mode" << std::setw(6) << "cpu"
+              << std::right << std::setw(14) << "work us" << std::setw(14) << "cpu us"
+              << std::setw(14) << "wake us" << std::setw(14) << "energy uJ" << "\n";
+
+    for (const Mode& mode : modes) {
+        for (int cpu = -1; cpu < cpus; cpu++) {
+            WorkerPolicy policy;
+            policy.priority = mode.priority;
+            policy.efficient = mode.efficient;
+            // -1 leaves the thread free to run anywhere
+            policy.affinity = (cpu < 0) ? 0 : (1ULL << cpu);
+            policy.apply();
+
+            std::vector<double> work, used, wake;
+            uint64_t energy_start = 0, energy_end = 0;
+            bool energy = read_energy(energy_start);
+
+            for (int i = 0; i < iterations; i++) {
+                uint64_t cpu_start = thread_cpu_time();
+                auto start = std::chrono::steady_clock::now();
+
+                volatile uint64_t sink = spin(2000000);
+                (void)sink;
+
+                auto end = std::chrono::steady_clock::now();
+                work.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+                used.push_back(static_cast<double>(thread_cpu_time() - cpu_start));
+
+                start = std::chrono::steady_clock::now();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                end = std::chrono::steady_clock::now();
+                wake.push_back(std::chrono::duration<double, std::micro>(end - start).count() - 1000.0);
+            }
+
+            energy = energy && read_energy(energy_end) && (energy_end >= energy_start);
+
+            std::sort(work.begin(), work.end());
+            std::sort(used.begin(), used.end());
+            std::sort(wake.begin(), wake.end());
+
+            std::cout << std::left << std::setw(8) << mode.label
+                      << std::setw(6) << ((cpu < 0) ? std::string("any") : std::to_string(cpu))
+                      << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(14) << work[work.size() / 2]
+                      << std::setw(14) << used[used.size() / 2]
+                      << std::setw(14) << wake[wake.size() / 2];
+
+            if (energy) std::cout << std::setw(14) << ((energy_end - energy_start) / iterations);
+            else std::cout << std::setw(14) << "-";
+
+            std::cout << "\n";
+        }
+    }
+}
+
+// A process start to replay, at a virtual time in milliseconds
+struct ReplayStart {
+    int64_t time;
+    uint32_t pid;
+    uint32_t ppid;
+    std::string name;
+
+    bool operator>(const ReplayStart& other) const { return time > other.time; }
+};
+
+struct ReplayWorkload {
+    std::vector<ReplayStart> starts;
+    std::unordered_set<std::string> targets;
+    // Targets whose supervisor starts them again this many milliseconds
+    // after they are killed
+    std::unordered_map<std::string, int> respawn;
+    // Respawned targets are started by the latest instance of this parent
+    std::unordered_map<std::string, std::string> parent;
+    int64_t end = 0;
+};
+
+class MemorySource : public ProcessSource, public ProcessControl {
+    /*
+    In-memory process table, so sweeps can be replayed without touching the
+    real processes of the machine. It is both where the engine snapshots
+    processes and how its terminator kills them; a handle is just the PID.
+    */
+
+    std::vector<ProcessInfo> table;
+
+    static ProcessHandle handle(uint32_t pid) {
+#ifdef _WIN32
+        return reinterpret_cast<ProcessHandle>(static_cast<uintptr_t>(pid));
+#else
+        return static_cast<ProcessHandle>(pid);
+#endif
+    }
+
+    static uint32_t pid(ProcessHandle handle) {
+#ifdef _WIN32
+        return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(handle));
+#else
+        return static_cast<uint32_t>(handle);
+#endif
+    }
+
+    std::vector<ProcessInfo>::iterator find(uint32_t pid) {
+        return std::find_if(table.begin(), table.end(),
+                            [pid](const ProcessInfo& info) { return info.pid == pid; });
+    }
+
+public:
+    // Processes terminated since the caller last cleared it
+    std::vector<ProcessInfo> killed;
+
+    bool snapshot(std::vector<ProcessInfo>& processes) override {
+        // Assigning keeps the capacity of `processes`, like the real backends
+        processes = table;
+        return true;
+    }
+
+    const char* name() const override { return "memory"; }
+
+    void start(uint32_t pid, uint32_t ppid, const std::string& name, int64_t time) {
+        // Kept in PID order like /proc, so with reused PIDs a parent can be
+        // listed after its children, as on a real machine
+        auto position = std::lower_bound(table.begin(), table.end(), pid,
+                                         [](const ProcessInfo& info, uint32_t value) { return info.pid < value; });
+
+        ProcessInfo& info = *table.emplace(position);
+        info.pid = pid;
+        info.ppid = ppid;
+        // Virtual start times stand in for creation times, which is what
+        // the process tree compares to spot reused PIDs
+        info.create_time = static_cast<uint64_t>(time) + 1;
+        std::strncpy(info.name, name.c_str(), PROCESS_NAME_LENGTH - 1);
+        info.name[PROCESS_NAME_LENGTH - 1] = '\0';
+    }
+
+    ProcessHandle open(uint32_t pid) override {
+        return (find(pid) != table.end()) ? handle(pid) : INVALID_PROCESS_HANDLE;
+    }
+
+    void close(ProcessHandle) override {}
+
+    bool terminate(ProcessHandle handle) override {
+        auto it = find(pid(handle));
+        if (it == table.end()) return false;
+
+        killed.push_back(*it);
+        table.erase(it);
+        return true;
+    }
+
+    // Nothing has a window to close
+    bool request_close(ProcessHandle, uint32_t) override { return false; }
+
+    bool wait(ProcessHandle handle, int) override {
+        return find(pid(handle)) == table.end();
+    }
+};
+
+static std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+bool load_journal(const std::string& path, ReplayWorkload& workload) {
+    /*
+    Read the process starts out of a journal written by the engine.
+
+    The journal only knows when a process was first matched, so that is
+    taken as its start; starts are thereby rounded up to the interval the
+    journal was recorded with. Every matched name is a target. Returns false
+    if the file isn't a journal.
+    */
+
+    std::ifstream file(path, std::ios::binary);
+
+    JournalHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        (header.magic != JOURNAL_MAGIC) || (header.version != JOURNAL_VERSION)) {
+        return false;
+    }
+
+    std::unordered_set<uint32_t> seen;
+    JournalRecord record;
+    int64_t origin = -1;
+
+    while (file.read(reinterpret_cast<char*>(&record), sizeof(record)) && (record.sequence != 0)) {
+        if (record.type != Events::PROCESS_MATCHED) continue;
+        if (!seen.insert(record.pid).second) continue;
+
+        if (origin < 0) origin = record.timestamp;
+
+        std::string name(record.name, strnlen(record.name, JOURNAL_NAME_LENGTH));
+        workload.starts.push_back({record.timestamp - origin, record.pid, 0, name});
+        workload.targets.insert(lowercase(name));
+    }
+
+    return true;
+}
+
+bool load_trace(const std::string& path, ReplayWorkload& workload) {
+    /*
+    Read a process start trace from a text file. Each line is either
+
+        target NAME
+        respawn NAME MILLISECONDS
+        TIME PID PPID NAME
+
+    where TIME is in milliseconds from the start of the trace. Lines starting
+    with # are comments.
+    */
+
+    std::ifstream file(path);
+    if (!file) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || (line[0] == '#')) continue;
+
+        std::istringstream fields(line);
+        std::string first;
+        fields >> first;
+
+        if (first == "target") {
+            std::string name;
+            std::getline(fields >> std::ws, name);
+            workload.targets.insert(lowercase(name));
+        }
+        else if (first == "respawn") {
+            std::string name;
+            int delay = 0;
+            fields >> name >> delay;
+            workload.respawn[lowercase(name)] = delay;
+        }
+        else {
+            ReplayStart start;
+            start.time = std::atoll(first.c_str());
+            fields >> start.pid >> start.ppid;
+            std::getline(fields >> std::ws, start.name);
+            workload.starts.push_back(start);
+        }
+    }
+
+    return true;
+}
+
+void synthesize(ReplayWorkload& workload, int hours) {
+    /*
+    Generate a school day of DyKnow: a supervisor that starts the monitoring
+    executables and starts each again two to four seconds after it is
+    killed, among a few hundred unrelated processes.
+    */
+
+    std::mt19937 random(42);
+
+    uint32_t pid = 1000;
+    workload.starts.push_back({0, 900, 4, "DyKnowService.exe"});
+
+    for (int i = 0; i < 300; i++) {
+        workload.starts.push_back({0, pid++, 4, "svchost" + std::to_string(i) + ".exe"});
+    }
+
+    // dkInteractive.exe is itself a target and the parent of the others
+    uint32_t interactive = pid++;
+    workload.targets.insert("dkinteractive.exe");
+    workload.respawn["dkinteractive.exe"] = 3000;
+    workload.starts.push_back({0, interactive, 900, "dkInteractive.exe"});
+
+    const char* targets[] = {"kyplu.exe", "amjbk.exe", "winProcess.exe"};
+    for (const char* target : targets) {
+        workload.targets.insert(lowercase(target));
+        workload.respawn[lowercase(target)] = 2000 + static_cast<int>(random() % 2000);
+        workload.parent[lowercase(target)] = "dkinteractive.exe";
+        workload.starts.push_back({static_cast<int64_t>(random() % 1000), pid++, interactive, target});
+    }
+
+    workload.end = static_cast<int64_t>(hours) * 3600 * 1000;
+}
+
+void percentiles(const char* label, std::vector<double>& values, const char* unit) {
+    if (values.empty()) {
+        std::cout << std::left << std::setw(22) << label << "none\n";
+        return;
+    }
+
+    std::sort(values.begin(), values.end());
+
+    double total = 0;
+    for (double value : values) total += value;
+
+    auto at = [&values](double fraction) {
+        return values[std::min(values.size() - 1, static_cast<std::size_t>(values.size() * fraction))];
+    };
+
+    std::cout << std::left << std::setw(22) << label
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << (total / values.size()) << " mean"
+              << std::setw(10) << at(0.5) << " p50"
+              << std::setw(10) << at(0.95) << " p95"
+              << std::setw(10) << at(0.99) << " p99"
+              << std::setw(10) << values.back() << " max " << unit << "\n";
+}
+
+void benchmark_replay(const std::string& source, int interval, double speed) {
+    /*
+    Replay a recorded or synthetic day of process starts through the engine
+    at `interval` milliseconds per sweep.
+
+    Each step runs the real `Engine::sweep()` on a `ManualClock`, against an
+    in-memory process table that is both its process source and how its
+    terminator kills, so the shipped discovery, matching, ordering and kill
+    path are measured. The targets are empty files under a temporary root.
+    The supervisor then starts respawning targets again. Time is virtual:
+    with a `speed` of 0 the day runs as fast as possible, and otherwise each
+    sweep waits its interval divided by `speed`.
+
+    Kill latency is the virtual time from a process starting to the sweep
+    that kills it, which is how long DyKnow got to run. CPU per sweep is the
+    real CPU time of the sweep on the replaying thread.
+    */
+
+    ReplayWorkload workload;
+
+    if (source == "synthetic") synthesize(workload, 8);
+    else if (!load_journal(source, workload) && !load_trace(source, workload)) {
+        std::cerr << "Unable to read " << source << "!\n";
+        return;
+    }
+
+    std::priority_queue<ReplayStart, std::vector<ReplayStart>, std::greater<ReplayStart>> pending(
+        std::greater<ReplayStart>(), workload.starts);
+
+    for (const auto& start : workload.starts) workload.end = std::max(workload.end, start.time);
+    workload.end += interval;
+
+    std::filesystem::path folder = std::filesystem::temp_directory_path() / "dieknow-replay";
+    std::filesystem::remove_all(folder);
+    std::filesystem::create_directories(folder / "Targets");
+    for (const auto& name : workload.targets) std::ofstream(folder / "Targets" / name);
+
+    // The replaying thread is measured as it is, and nothing is hashed or
+    // journaled
+    Settings settings;
+    settings.override("match_by_hash", "false");
+    settings.override("journal_sweeps", "false");
+    settings.override("worker_priority", "normal");
+    settings.override("worker_efficiency", "false");
+    settings.override("battery_worker_efficiency", "false");
+
+    MemorySource memory;
+    ManualClock clock;
+    EventQueue events;
+    Discovery discovery;
+    IdentityCache identities;
+    HandleCache handles(32, &memory);
+    Terminator terminator(&handles, &clock, &memory);
+    RootRegistry roots;
+    Governor governor;
+    PowerMonitor power;
+    ActivityRing activity;
+    Journal journal;
+    Histogram kill_latency;
+    Histogram sweep_duration;
+    TargetRegistry registry;
+
+    Engine engine(
+        {
+            &settings, &events, &discovery, &identities, &handles, &terminator, &roots,
+            &governor, &power, &activity, nullptr, &journal, &kill_latency, &sweep_duration,
+            &registry, &memory
+        },
+        clock,
+        (folder / "identity.cache").string()
+    );
+
+    roots.add(folder.string());
+
+    std::unordered_map<uint32_t, int64_t> started;
+    std::unordered_map<std::string, uint32_t> latest;
+    // PIDs of processes that are running or about to start
+    std::unordered_set<uint32_t> used;
+    for (const auto& start : workload.starts) used.insert(start.pid);
+    std::vector<double> latencies, cpu;
+    // Supervisors don't respawn on a fixed beat, and respawns get whatever
+    // PID is free, a multiple of 4 as on Windows
+    std::mt19937 random(7);
+
+    // The engine logs every kill, which would drown the results
+    std::streambuf* output = std::cout.rdbuf(nullptr);
+
+    auto wall = std::chrono::steady_clock::now();
+
+    for (int64_t now = 0; now <= workload.end; now += interval) {
+        while (!pending.empty() && (pending.top().time <= now)) {
+            ReplayStart start = pending.top();
+            pending.pop();
+
+            std::string name = lowercase(start.name);
+            auto parent = workload.parent.find(name);
+            if ((parent != workload.parent.end()) && latest.count(parent->second)) {
+                start.ppid = latest[parent->second];
+            }
+
+            memory.start(start.pid, start.ppid, start.name, start.time);
+            started[start.pid] = start.time;
+            latest[name] = start.pid;
+        }
+
+        uint64_t cpu_start = thread_cpu_time();
+        engine.sweep();
+        cpu.push_back(static_cast<double>(thread_cpu_time() - cpu_start));
+
+        for (const ProcessInfo& process : memory.killed) {
+            latencies.push_back(static_cast<double>(now - started[process.pid]));
+            started.erase(process.pid);
+            used.erase(process.pid);
+
+            auto rule = workload.respawn.find(lowercase(process.name));
+            if ((rule != workload.respawn.end()) && (now < workload.end)) {
+                int64_t delay = rule->second + static_cast<int64_t>(random() % (rule->second / 2 + 1));
+                uint32_t pid;
+                do pid = 4 * (1000 + static_cast<uint32_t>(random() % 15000));
+                while (!used.insert(pid).second);
+
+                pending.push({now + delay, pid, process.ppid, process.name});
+            }
+        }
+        memory.killed.clear();
+
+        clock.advance(std::chrono::milliseconds(interval));
+
+        if (speed > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(interval * 1000 / speed)));
+        }
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall).count();
+
+    std::cout.rdbuf(output);
+    std::cout.clear();
+
+    std::filesystem::remove_all(folder);
+
+    std::cout << "Replayed " << (workload.end / 1000) << " s of " << source << " in "
+              << std::fixed << std::setprecision(2) << elapsed << " s: "
+              << cpu.size() << " sweeps at " << interval << " ms, "
+              << latencies.size() << " kills, " << engine.get_respawns_prevented() << " respawns prevented\n";
+
+    percentiles("kill latency", latencies, "ms");
+    percentiles("cpu per sweep", cpu, "us");
+}
+
+// The settings loader before it read files in one go, kept to compare
+// reload costs against. It read line by line and copied every key and value.
+class LegacySettings {
+    StringMap settings;
+    std::string path;
+
+public:
+    bool load(const std::string& file_name) {
+        std::ifstream file(file_name);
+        if (!file.is_open()) return false;
+
+        this->path = file_name;
+
+        std::string line;
+        while (std::getline(file, line)) {
+            if ((line.empty()) ||
+                (line[0] == '#') ||
+                (line.substr(0, 2) == "//")) continue;
+
+            auto delimeter = line.find('=');
+            if (delimeter == std::string::npos) continue;
+
+            std::string key = line.substr(0, delimeter);
+            std::string value = line.substr(delimeter + 1);
+            settings[key] = value;
+        }
+
+        return true;
+    }
+
+    bool update() {
+        auto previous = settings;
+        load(path);
+        return previous != settings;
+    }
+};
+
+void write_settings(const std::string& path, int lines, int revision) {
+    /*
+    Write a settings file of about `lines` lines, with comments, blank lines,
+    padding and CRLF endings like a hand-edited file. `revision` is the value
+    of the last setting, so rewriting with another revision changes exactly
+    one value.
+    */
+
+    std::ofstream file(path, std::ios::binary);
+
+    file << "# Generated by benchmark settings\r\n\r\n";
+    for (int index = 0; index < lines; index++) {
+        if (index % 10 == 0) file << "// Section " << (index / 10) << "\r\n";
+        file << "setting_" << index << " = " << (index * 7) << "\r\n";
+    }
+    file << "revision=" << revision << "\r\n";
+}
+
+template <typename Loader>
+void time_settings(const char* label, const std::string& path, int lines, int iterations) {
+    std::vector<double> loads, unchanged, changed;
+    std::string name = label;
+
+    auto elapsed = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    for (int index = 0; index < iterations; index++) {
+        write_settings(path, lines, index);
+
+        Loader loader;
+        auto start = std::chrono::steady_clock::now();
+        loader.load(path);
+        loads.push_back(elapsed(start));
+
+        start = std::chrono::steady_clock::now();
+        bool result = loader.update();
+        unchanged.push_back(elapsed(start));
+        if (result) std::cout << name << ": an unchanged file reported a change\n";
+
+        write_settings(path, lines, index + iterations);
+
+        start = std::chrono::steady_clock::now();
+        result = loader.update();
+        changed.push_back(elapsed(start));
+        if (!result) std::cout << name << ": a changed file reported no change\n";
+    }
+
+    percentiles((name + " load").c_str(), loads, "us");
+    percentiles((name + " unchanged").c_str(), unchanged, "us");
+    percentiles((name + " changed").c_str(), changed, "us");
+}
+
+void benchmark_settings(int lines, int iterations) {
+    /*
+    Time loading a settings file, reloading it unchanged (what the GUI does
+    on almost every refresh) and reloading it after one value changed, with
+    the current loader and the legacy line-by-line one. Both run on a small
+    file like the real settings.conf and on one of `lines` lines. Files are
+    written outside the timed regions.
+    */
+
+    std::string path = (std::filesystem::temp_directory_path() / "dieknow_benchmark.conf").string();
+
+    for (int size : {50, lines}) {
+        std::cout << size << " settings, " << iterations << " iterations\n";
+        time_settings<Settings>("current", path, size, iterations);
+        time_settings<LegacySettings>("legacy", path, size, iterations);
+        std::cout << "\n";
+    }
+
+    std::filesystem::remove(path);
+}
+
+int main(int argc, char** argv) {
+    std::string mode = (argc > 1) ? argv[1] : "";
+
+    if (mode == "idle") {
+#ifdef _WIN32
+        Sleep(INFINITE);
+#else
+        pause();
+#endif
+        return 0;
+    }
+
+    if (mode == "process") {
+        // Extra processes to spawn, e.g. 0, 2700 and 29700 on a machine that
+        // idles at 300 to measure at 300, 3k and 30k processes
+        int extra = (argc > 2) ? std::atoi(argv[2]) : 0;
+        int iterations = (argc > 3) ? std::atoi(argv[3]) : 200;
+
+        benchmark_process(argv[0], extra, std::max(1, iterations));
+        return 0;
+    }
+
+    if (mode == "policy") {
+        int iterations = (argc > 2) ? std::atoi(argv[2]) : 50;
+
+        benchmark_policy(std::max(1, iterations));
+        return 0;
+    }
+
+    if ((mode == "replay") && (argc > 2)) {
+        int interval = (argc > 3) ? std::atoi(argv[3]) : 1000;
+        double speed = (argc > 4) ? std::atof(argv[4]) : 0;
+
+        benchmark_replay(argv[2], std::max(1, interval), speed);
+        return 0;
+    }
+
+    if (mode == "settings") {
+        int lines = (argc > 2) ? std::atoi(argv[2]) : 100000;
+        int iterations = (argc > 3) ? std::atoi(argv[3]) : 50;
+
+        benchmark_settings(std::max(1, lines), std::max(1, iterations));
+        return 0;
+    }
+
+    std::cout << "Usage: benchmark process [spawn] [iterations]\n"
+              << "       benchmark policy [iterations]\n"
+              << "       benchmark replay <journal|trace|synthetic> [interval_ms] [speed]\n"
+              << "       benchmark settings [lines] [iterations]\n";
+    return 1;
+}
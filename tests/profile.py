@@ -0,0 +1,275 @@
+"""Build api.dll and gui.dll with profile-guided and link-time optimization.
+
+The DLLs are built three times into the same folder:
+
+1. The plain build from COMPILING.md, which is measured as the baseline.
+2. An instrumented build, which is trained by running the workload below.
+3. The optimized build, recompiled with the training profile and `-flto`
+   so the settings, discovery and process code is inlined across files.
+
+The workload sweeps a folder of target executables that keep respawning, and
+refreshes the GUI as fast as the `update` setting allows. The average sweep
+and `Application::update()` times of the plain and optimized builds are
+printed side by side. Pass `--install` to copy the optimized DLLs into
+src/dlls afterwards.
+
+The GUI is only trained and measured where DyKnow is installed, since it
+refuses to start anywhere else. Close DieKnow before running this, or it
+holds the sweep lease and the workload never sweeps.
+"""
+
+import argparse
+import ctypes
+import os
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+BUILD_FOLDER = os.path.join(ROOT, "build", "profile")
+PROFILE_FOLDER = os.path.join(BUILD_FOLDER, "gcda")
+
+# Keep in step with COMPILING.md and .github/workflows/build.yml
+API_SOURCES = [
+    "api.cpp", "settings.cpp", "events.cpp", "discovery.cpp", "identity.cpp",
+    "process.cpp", "handles.cpp", "termination.cpp", "roots.cpp",
+    "governor.cpp", "scheduling.cpp", "power.cpp", "activity.cpp",
+    "shared.cpp", "pipe.cpp", "metrics.cpp", "journal.cpp", "clock.cpp",
+    "watcher.cpp", "registry.cpp", "engine.cpp",
+]
+GUI_SOURCES = ["gui.cpp"]
+
+FLAGS = ["-Ofast", "-Wall", "-shared", "-std=c++20", "-static"]
+STAGES = {
+    "plain": [],
+    "instrumented": ["-flto=auto", f"-fprofile-generate={PROFILE_FOLDER}",
+                     "-fprofile-update=atomic"],
+    # Code the workload never reached is still optimized for speed
+    "optimized": ["-flto=auto", f"-fprofile-use={PROFILE_FOLDER}",
+                  "-fprofile-correction", "-fprofile-partial-training"],
+}
+
+# Names the workload gives its copies of the target executable
+TARGETS = ["dyknowclient.exe", "dyknowmonitor.exe", "dyknowupdater.exe"]
+
+# Written next to the workload for the GUI to load, so it refreshes as often
+# as it can without touching the real settings. The sweep runs on defaults.
+SETTINGS = """\
+update=10
+background_update=10
+"""
+
+
+def build(stage):
+    """Compile both DLLs for a stage. They are always written to the same
+    paths, because the profile files are named after the output."""
+
+    os.makedirs(BUILD_FOLDER, exist_ok=True)
+
+    for name, sources, libraries in (
+            ("api.dll", API_SOURCES, ["-lgdi32"]),
+            ("gui.dll", GUI_SOURCES, ["-lgdi32", "-lcomctl32", "-lpsapi"])):
+        command = (["g++"] + FLAGS + STAGES[stage] +
+                   ["-o", os.path.join(BUILD_FOLDER, name)] +
+                   [os.path.join(ROOT, "src", source) for source in sources] +
+                   libraries)
+
+        print(f"Building {stage} {name}...")
+        subprocess.run(command, check=True)
+
+
+def sweep_workload(seconds):
+    """Sweep a folder of respawning targets and print the average sweep time
+    in milliseconds, from the engine's own sweep duration histogram."""
+
+    lib = ctypes.CDLL(os.path.join(BUILD_FOLDER, "api.dll"))
+    lib.start_monitoring.argtypes = [ctypes.c_char_p]
+    lib.get_metrics.restype = ctypes.c_char_p
+
+    folder = os.path.abspath("DyKnow")
+    nested = os.path.join(folder, "Updates")
+    os.makedirs(nested, exist_ok=True)
+
+    # A small console program that runs until it is killed
+    ping = os.path.join(os.environ.get("SystemRoot", r"C:\Windows"),
+                        "System32", "PING.EXE")
+    executables = []
+    for index, name in enumerate(TARGETS):
+        path = os.path.join(nested if index else folder, name)
+        shutil.copy(ping, path)
+        executables.append(path)
+
+    for index in range(50):
+        with open(os.path.join(folder, f"resource{index}.dat"), "wb") as file:
+            file.write(b"\0" * 1024)
+
+    stopping = threading.Event()
+    spawned = []
+
+    def respawn():
+        while not stopping.is_set():
+            for path in executables:
+                spawned.append(subprocess.Popen(
+                    [path, "-n", "600", "127.0.0.1"],
+                    stdout=subprocess.DEVNULL,
+                    creationflags=subprocess.CREATE_NO_WINDOW
+                ))
+            stopping.wait(0.25)
+
+    spawner = threading.Thread(target=respawn, daemon=True)
+    spawner.start()
+
+    lib.start_monitoring(folder.encode())
+    time.sleep(seconds)
+    lib.stop_monitoring()
+
+    stopping.set()
+    spawner.join()
+
+    # Let the monitor thread finish its last sweep before reading
+    time.sleep(1)
+
+    for process in spawned:
+        if process.poll() is None:
+            process.kill()
+
+    values = {}
+    for line in lib.get_metrics().decode().splitlines():
+        if line.startswith("dieknow_sweep_duration_seconds_"):
+            key, value = line.split()
+            values[key] = float(value)
+
+    total = values.get("dieknow_sweep_duration_seconds_sum", 0.0)
+    count = values.get("dieknow_sweep_duration_seconds_count", 0.0)
+
+    print((total * 1000 / count) if count else 0.0)
+
+
+def update_workload(refreshes):
+    """Refresh the GUI `refreshes` times and print the average refresh time
+    in milliseconds."""
+
+    lib = ctypes.CDLL(os.path.join(BUILD_FOLDER, "gui.dll"))
+    lib.profile_window.argtypes = [ctypes.c_int]
+    lib.profile_window.restype = ctypes.c_double
+
+    print(lib.profile_window(refreshes))
+
+
+def folder_workload(_):
+    """Print the DyKnow folder the DLLs look for."""
+
+    lib = ctypes.CDLL(os.path.join(BUILD_FOLDER, "api.dll"))
+    lib.get_folder_path.restype = ctypes.c_char_p
+
+    print(lib.get_folder_path().decode())
+
+
+WORKLOADS = {
+    "sweep": sweep_workload,
+    "update": update_workload,
+    "folder": folder_workload,
+}
+
+
+def run(workload, amount):
+    """Run a workload against the DLLs in the build folder and return the
+    last line it printed.
+
+    Each runs in a fresh process, so the DLLs start from scratch and are
+    unloaded again before the next build overwrites them, and in an empty
+    folder with its own settings.
+    """
+
+    with tempfile.TemporaryDirectory() as folder:
+        with open(os.path.join(folder, "settings.conf"), "w") as file:
+            file.write(SETTINGS)
+
+        result = subprocess.run(
+            [sys.executable, os.path.abspath(__file__),
+             "--workload", workload, str(amount)],
+            cwd=folder, check=True, capture_output=True, text=True
+        )
+
+    return result.stdout.strip().splitlines()[-1]
+
+
+def measure(arguments, gui):
+    """Median of several runs of each workload."""
+
+    sweeps = [float(run("sweep", arguments.seconds))
+              for _ in range(arguments.runs)]
+    updates = ([float(run("update", arguments.refreshes))
+                for _ in range(arguments.runs)] if gui else [0.0])
+
+    return statistics.median(sweeps), statistics.median(updates)
+
+
+def main():
+    """Main starting point."""
+
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--seconds", type=int, default=30,
+                        help="how long each sweep workload runs")
+    parser.add_argument("--refreshes", type=int, default=1000,
+                        help="GUI refreshes per update workload")
+    parser.add_argument("--runs", type=int, default=3,
+                        help="runs of each workload to take the median of")
+    parser.add_argument("--install", action="store_true",
+                        help="copy the optimized DLLs into src/dlls")
+    parser.add_argument("--workload", nargs=2, help=argparse.SUPPRESS)
+    arguments = parser.parse_args()
+
+    if arguments.workload:
+        kind, amount = arguments.workload
+        WORKLOADS[kind](int(amount))
+        return 0
+
+    if os.name != "nt":
+        print("The DLLs only build on Windows.", file=sys.stderr)
+        return 1
+
+    build("plain")
+
+    gui = os.path.isdir(run("folder", 0))
+    if not gui:
+        print("DyKnow isn't installed, so the GUI won't be trained or measured.")
+
+    before = measure(arguments, gui)
+
+    shutil.rmtree(PROFILE_FOLDER, ignore_errors=True)
+    build("instrumented")
+
+    print("Training...")
+    run("sweep", arguments.seconds)
+    if gui:
+        run("update", arguments.refreshes)
+
+    build("optimized")
+    after = measure(arguments, gui)
+
+    print(f"\n{'':<24} {'plain':>10} {'optimized':>10} {'change':>8}")
+
+    for label, old, new in (("sweep (ms)", before[0], after[0]),
+                            ("update() (ms)", before[1], after[1])):
+        if not old:
+            continue
+
+        change = (new - old) / old * 100
+        print(f"{label:<24} {old:>10.3f} {new:>10.3f} {change:>+7.1f}%")
+
+    if arguments.install:
+        for name in ("api.dll", "gui.dll"):
+            shutil.copy(os.path.join(BUILD_FOLDER, name),
+                        os.path.join(ROOT, "src", "dlls", name))
+        print("\nInstalled the optimized DLLs into src/dlls.")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,392 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: tests/testengine.cpp
+DESCRIPTION: Checks of the engine's modules across threads and instances
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+
+Compile with g++ -O2 -std=c++20 -o testengine tests/testengine.cpp src/engine.cpp src/settings.cpp src/events.cpp src/discovery.cpp src/watcher.cpp src/identity.cpp src/process.cpp src/handles.cpp src/termination.cpp src/roots.cpp src/scheduling.cpp src/governor.cpp src/power.cpp src/activity.cpp src/shared.cpp src/journal.cpp src/metrics.cpp src/pipe.cpp src/clock.cpp src/registry.cpp
+*/
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+#include "../src/engine.h"
+
+// Segment the lease check shares, apart from the one real instances use
+#ifdef _WIN32
+#define TEST_STATUS_NAME "Local\\DieKnowTestEngine"
+#else
+#define TEST_STATUS_NAME "/dieknow-testengine"
+#endif
+
+
+// Events the callbacks below have seen, in order
+static std::atomic<int> delivered{0};
+static std::atomic<int> concurrent{0};
+static std::atomic<bool> overlapped{false};
+static std::atomic<bool> reordered{false};
+static std::atomic<uint32_t> last_pid{0};
+static EventQueue* queue = nullptr;
+static std::atomic<bool> unsubscribed{false};
+
+static void record(const Event* event) {
+    if (concurrent.fetch_add(1) > 0) overlapped = true;
+
+    // PIDs are pushed in increasing order
+    if (event->pid <= last_pid) reordered = true;
+    last_pid = event->pid;
+
+    // Long enough for a second dispatcher to overlap, were there one
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    delivered++;
+
+    concurrent--;
+}
+
+static void unsubscribe_self(const Event* event) {
+    concurrent++;
+    queue->unsubscribe();
+    unsubscribed = true;
+
+    // Still inside the callback while the test subscribes again and pushes
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    concurrent--;
+
+    record(event);
+}
+
+template <typename Condition>
+static bool wait_until(Condition condition) {
+    for (int i = 0; (i < 2000) && !condition(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return condition();
+}
+
+static bool check_resubscribe() {
+    /*
+    A callback that unsubscribes itself, followed by a new subscription from
+    another thread, must never leave two dispatchers delivering at once.
+    */
+
+    EventQueue events;
+    queue = &events;
+
+    uint32_t pid = 1;
+
+    for (int round = 0; round < 20; round++) {
+        int before = delivered;
+        unsubscribed = false;
+
+        events.subscribe(unsubscribe_self);
+        events.push(Events::TERMINATED, pid++, "first.exe");
+
+        // Subscribe again straight away, while the old dispatcher is still
+        // inside its callback
+        if (!wait_until([]() { return unsubscribed.load(); })) break;
+        for (int i = 0; i < 5; i++) events.push(Events::TERMINATED, pid++, "next.exe");
+        events.subscribe(record);
+
+        if (!wait_until([before]() { return delivered >= before + 6; })) break;
+
+        events.unsubscribe();
+    }
+
+    queue = nullptr;
+
+    if (delivered != 20 * 6) {
+        std::cerr << "Expected " << (20 * 6) << " events delivered, got " << delivered << "!\n";
+        return false;
+    }
+    if (overlapped) {
+        std::cerr << "Two dispatchers delivered events at once!\n";
+        return false;
+    }
+    if (reordered) {
+        std::cerr << "Events were delivered out of order!\n";
+        return false;
+    }
+
+    return true;
+}
+
+class FakeProcesses : public ProcessSource, public ProcessControl {
+    /*
+    A process table in memory, which is both where the engine snapshots
+    processes and how its terminator kills them; a handle is just the PID.
+    */
+
+    static ProcessHandle handle(uint32_t pid) {
+#ifdef _WIN32
+        return reinterpret_cast<ProcessHandle>(static_cast<uintptr_t>(pid));
+#else
+        return static_cast<ProcessHandle>(pid);
+#endif
+    }
+
+    static uint32_t pid(ProcessHandle handle) {
+#ifdef _WIN32
+        return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(handle));
+#else
+        return static_cast<uint32_t>(handle);
+#endif
+    }
+
+    std::vector<ProcessInfo>::iterator find(uint32_t pid) {
+        return std::find_if(table.begin(), table.end(),
+                            [pid](const ProcessInfo& info) { return info.pid == pid; });
+    }
+
+public:
+    std::vector<ProcessInfo> table;
+
+    void start(uint32_t pid, const char* name) {
+        ProcessInfo& info = table.emplace_back();
+        info.pid = pid;
+        info.ppid = 0;
+        info.create_time = pid;
+        std::strncpy(info.name, name, PROCESS_NAME_LENGTH - 1);
+        info.name[PROCESS_NAME_LENGTH - 1] = '\0';
+    }
+
+    bool snapshot(std::vector<ProcessInfo>& processes) override {
+        processes = table;
+        return true;
+    }
+
+    const char* name() const override { return "fake"; }
+
+    ProcessHandle open(uint32_t pid) override {
+        return (find(pid) != table.end()) ? handle(pid) : INVALID_PROCESS_HANDLE;
+    }
+
+    void close(ProcessHandle) override {}
+
+    bool terminate(ProcessHandle handle) override {
+        auto it = find(pid(handle));
+        if (it == table.end()) return false;
+
+        table.erase(it);
+        return true;
+    }
+
+    bool request_close(ProcessHandle, uint32_t) override { return false; }
+
+    bool wait(ProcessHandle handle, int) override {
+        return find(pid(handle)) == table.end();
+    }
+};
+
+struct Instance {
+    /*
+    An engine with the modules api.cpp gives it and its own mapping of the
+    test segment, which `check_lease` opens. Two of these in one process
+    stand in for gui.dll and api.dll loaded by the same interpreter. With
+    `processes`, it snapshots and kills those instead of the machine's.
+    */
+
+    Settings settings;
+    EventQueue events;
+    Discovery discovery;
+    IdentityCache identities;
+    HandleCache handles;
+    SystemClock clock;
+    Terminator terminator;
+    RootRegistry roots;
+    Governor governor;
+    PowerMonitor power;
+    ActivityRing activity;
+    SharedSegment shared;
+    Journal journal;
+    Histogram kill_latency;
+    Histogram sweep_duration;
+    TargetRegistry registry;
+
+    Engine engine;
+
+    explicit Instance(const std::filesystem::path& folder, FakeProcesses* processes = nullptr)
+        : handles(32, processes),
+          terminator(&handles, &clock, processes),
+          power((folder / "supplies").string()),
+          engine(
+              {
+                  &settings, &events, &discovery, &identities, &handles, &terminator, &roots,
+                  &governor, &power, &activity, &shared, &journal, &kill_latency, &sweep_duration,
+                  &registry, processes
+              },
+              clock,
+              (folder / "identity.cache").string()
+          ) {
+        settings.override("journal", "false");
+    }
+
+    uint64_t sweeps() const {
+        uint64_t total = 0;
+        for (int i = 0; i <= METRICS_BUCKETS; i++) total += sweep_duration.get_count(i);
+        return total;
+    }
+};
+
+static bool check_lease() {
+    /*
+    Of two engines in the same process, only one may hold the lease and
+    sweep.
+    */
+
+    std::filesystem::path folder = std::filesystem::temp_directory_path() / "dieknow-testengine";
+    std::filesystem::remove_all(folder);
+    std::filesystem::create_directories(folder);
+
+#ifndef _WIN32
+    shm_unlink(TEST_STATUS_NAME);
+#endif
+
+    bool passed = true;
+
+    {
+        Instance first(folder);
+        Instance second(folder);
+        first.shared.open(TEST_STATUS_NAME);
+        second.shared.open(TEST_STATUS_NAME);
+
+        if (!first.shared.is_open() || !second.shared.is_open()) {
+            std::cerr << "Unable to open the test status segment!\n";
+            passed = false;
+        }
+        else {
+            std::atomic<bool> running{true};
+            std::thread a([&]() { first.engine.run(running); });
+            std::thread b([&]() { second.engine.run(running); });
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+            uint64_t holder = first.shared.get_holder();
+            running = false;
+            a.join();
+            b.join();
+
+            uint64_t swept_first = first.sweeps();
+            uint64_t swept_second = second.sweeps();
+
+            if ((swept_first > 0) && (swept_second > 0)) {
+                std::cerr << "Both engines in one process swept (" << swept_first << " and "
+                          << swept_second << " sweeps)!\n";
+                passed = false;
+            }
+            else if ((swept_first == 0) && (swept_second == 0)) {
+                std::cerr << "Neither engine swept!\n";
+                passed = false;
+            }
+            else if ((holder != first.engine.get_lease()) && (holder != second.engine.get_lease())) {
+                std::cerr << "The lease was held by neither engine!\n";
+                passed = false;
+            }
+            else if (first.shared.get_holder() != 0) {
+                std::cerr << "The lease was not released when monitoring stopped!\n";
+                passed = false;
+            }
+        }
+    }
+
+#ifndef _WIN32
+    shm_unlink(TEST_STATUS_NAME);
+#endif
+    std::filesystem::remove_all(folder);
+
+    return passed;
+}
+
+static bool check_many_targets() {
+    /*
+    Targets past the first chunk of the registry still get an ID, and are
+    still killed.
+    */
+
+    std::filesystem::path folder = std::filesystem::temp_directory_path() / "dieknow-testtargets";
+    std::filesystem::remove_all(folder);
+    std::filesystem::create_directories(folder / "root");
+
+    const int count = TARGET_CHUNK * 2 + 1;
+    for (int i = 0; i < count; i++) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "target-%03d.exe", i);
+        std::ofstream(folder / "root" / name, std::ios::binary) << name;
+    }
+
+    bool passed = true;
+
+    {
+        FakeProcesses processes;
+        processes.start(4242, "TARGET-256.exe");
+
+        Instance instance(folder, &processes);
+        instance.settings.override("min_depth", "1");
+        instance.settings.override("max_depth", "1");
+        instance.settings.override("match_by_hash", "false");
+        instance.roots.add((folder / "root").string());
+
+        // Kills are signalled during the sweep and confirmed on the next tick
+        instance.engine.sweep();
+        instance.engine.advance();
+
+        uint32_t target = instance.registry.find("target-256.exe");
+
+        if (instance.registry.size() != static_cast<uint32_t>(count)) {
+            std::cerr << "Expected " << count << " targets interned, got " << instance.registry.size() << "!\n";
+            passed = false;
+        }
+        else if ((target == TARGET_NONE) || (target < TARGET_CHUNK)) {
+            std::cerr << "The last target got no ID past the first chunk!\n";
+            passed = false;
+        }
+        else if (!processes.table.empty() || (instance.registry.get(target).killed != 1)) {
+            std::cerr << "A target past the first chunk was not killed!\n";
+            passed = false;
+        }
+    }
+
+    std::filesystem::remove_all(folder);
+
+    return passed;
+}
+
+int main() {
+    bool passed = true;
+
+    passed = check_resubscribe() && passed;
+    passed = check_lease() && passed;
+    passed = check_many_targets() && passed;
+
+    if (!passed) return 1;
+
+    std::cout << "All engine checks passed.\n";
+    return 0;
+}
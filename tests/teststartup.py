@@ -0,0 +1,27 @@
+"""Measure the cold start time of the DieKnow Python shell."""
+
+import os
+import subprocess
+import sys
+import time
+
+SRC_FOLDER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src")
+RUNS = 10
+
+timings = []
+
+for _ in range(RUNS):
+    start = time.perf_counter()
+    subprocess.run(
+        [sys.executable, "-c", "import dieknow"],
+        cwd=SRC_FOLDER,
+        check=True
+    )
+    timings.append(time.perf_counter() - start)
+
+timings.sort()
+
+print(f"Imported dieknow {RUNS} times in a fresh interpreter.")
+print(f"Fastest: {round(timings[0] * 1000, 1)} ms")
+print(f"Median: {round(timings[RUNS // 2] * 1000, 1)} ms")
+print(f"Slowest: {round(timings[-1] * 1000, 1)} ms")
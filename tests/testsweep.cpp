@@ -0,0 +1,196 @@
+/*
+COPYRIGHT (C) 2024 ETHAN CHAN
+
+ALL RIGHTS RESERVED. UNAUTHORIZED COPYING, MODIFICATION, DISTRIBUTION, OR USE
+OF THIS SOFTWARE WITHOUT PRIOR PERMISSION IS STRICTLY PROHIBITED.
+
+THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM,
+OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+PROJECT NAME: DieKnow
+FILENAME: tests/testsweep.cpp
+DESCRIPTION: Checks that a steady-state sweep doesn't allocate
+AUTHOR: Ethan Chan
+DATE: 2024-11-13
+VERSION: 1.0.1
+
+Compile with g++ -O2 -std=c++20 -o testsweep tests/testsweep.cpp src/engine.cpp src/settings.cpp src/events.cpp src/discovery.cpp src/watcher.cpp src/identity.cpp src/process.cpp src/handles.cpp src/termination.cpp src/roots.cpp src/scheduling.cpp src/governor.cpp src/power.cpp src/activity.cpp src/shared.cpp src/journal.cpp src/metrics.cpp src/pipe.cpp src/clock.cpp src/registry.cpp
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <unordered_set>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "../src/engine.h"
+
+// Sweeps run before counting, which size every reused buffer
+#define WARMUP_SWEEPS 5
+#define COUNTED_SWEEPS 100
+
+
+// Every allocation on any thread is counted while `counting` is set
+static std::atomic<bool> counting{false};
+static std::atomic<std::size_t> allocations{0};
+
+void* operator new(std::size_t size) {
+    if (counting.load(std::memory_order_relaxed)) allocations++;
+
+    void* memory = std::malloc(size ? size : 1);
+    if (!memory) throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+static void write(const std::filesystem::path& path, const std::string& text) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path, std::ios::binary) << text;
+}
+
+struct Fixture {
+    /*
+    The modules api.cpp gives the engine, without the shared status segment
+    so the test always sweeps.
+    */
+
+    Settings settings;
+    EventQueue events;
+    Discovery discovery;
+    IdentityCache identities;
+    HandleCache handles;
+    SystemClock clock;
+    Terminator terminator{&handles, &clock};
+    RootRegistry roots;
+    Governor governor;
+    PowerMonitor power;
+    ActivityRing activity;
+    Journal journal;
+    Histogram kill_latency;
+    Histogram sweep_duration;
+    TargetRegistry registry;
+
+    Engine engine;
+
+    explicit Fixture(const std::filesystem::path& folder)
+        : power((folder / "supplies").string()),
+          engine(
+              {
+                  &settings, &events, &discovery, &identities, &handles, &terminator, &roots,
+                  &governor, &power, &activity, nullptr, &journal, &kill_latency, &sweep_duration,
+                  &registry, nullptr
+              },
+              clock,
+              (folder / "identity.cache").string()
+          ) {}
+};
+
+int main() {
+    std::filesystem::path folder = std::filesystem::temp_directory_path() / "dieknow-testsweep";
+    std::filesystem::remove_all(folder);
+
+    // Long enough names and paths that none fit a small string buffer
+    write(folder / "root" / "DyKnow Interactive Client Launcher.exe", "launcher");
+    write(folder / "root" / "Monitoring" / "kworker-impostor-service.exe", "impostor");
+    write(folder / "root" / "Monitoring" / "Logs" / "readme.txt", "not a target");
+    write(folder / "root" / "Updates" / "dyknow-classroom-updater.exe", "updater");
+    write(folder / "supplies" / "AC" / "type", "Mains\n");
+    write(folder / "supplies" / "AC" / "online", "1\n");
+    write(folder / "dieknow.conf",
+          "interval=0\n"
+          "min_depth=1\n"
+          "max_depth=3\n"
+          "include=*.exe;*.com;*.scr;*.bat\n"
+          "exclude=Logs\n"
+          "worker_priority=below_normal\n");
+
+    Fixture fixture(folder);
+    Engine& engine = fixture.engine;
+
+    if (!fixture.settings.load((folder / "dieknow.conf").string())) {
+        std::cerr << "Unable to load the test settings!\n";
+        return 1;
+    }
+    fixture.roots.add((folder / "root").string());
+    fixture.journal.open((folder / "journal.dkj").string(), 4096, 2);
+
+    for (int i = 0; i < WARMUP_SWEEPS; i++) engine.sweep();
+
+    if (engine.get_targets().size() != 3) {
+        std::cerr << "Expected 3 targets, found " << engine.get_targets().size() << "!\n";
+        return 1;
+    }
+
+    counting = true;
+    for (int i = 0; i < COUNTED_SWEEPS; i++) engine.sweep();
+    counting = false;
+
+    std::size_t reused = fixture.discovery.get_reused();
+    std::filesystem::remove_all(folder);
+
+    if (reused < COUNTED_SWEEPS) {
+        std::cerr << "Only " << reused << " sweeps reused the cached walk!\n";
+        return 1;
+    }
+
+    if (allocations > 0) {
+        std::cerr << allocations << " allocations in " << COUNTED_SWEEPS << " steady-state sweeps!\n";
+        return 1;
+    }
+
+    // A PID reused by a process of another name, with no creation time to
+    // tell them apart (as Toolhelp32 reports), must be looked up again
+    uint32_t target = fixture.registry.find("dyknow-classroom-updater.exe");
+    uint64_t matched = fixture.registry.get(target).matched;
+
+    std::vector<ProcessInfo> recycled(1);
+    recycled[0].pid = 0x7FFFFFF0;
+    recycled[0].ppid = 0;
+    recycled[0].create_time = 0;
+    std::strcpy(recycled[0].name, "notepad.exe");
+    engine.match(recycled, false);
+
+    std::strcpy(recycled[0].name, "DyKnow-Classroom-Updater.exe");
+    engine.match(recycled, false);
+
+    if (fixture.registry.get(target).matched != matched + 1) {
+        std::cerr << "A reused PID without a creation time kept its old verdict!\n";
+        return 1;
+    }
+
+    std::cout << "No allocations in " << COUNTED_SWEEPS << " steady-state sweeps.\n";
+    return 0;
+}